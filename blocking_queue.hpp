@@ -0,0 +1,293 @@
+#ifndef BLOCKING_QUEUE_HPP_
+#define BLOCKING_QUEUE_HPP_
+
+#include <string>
+#include <iostream>
+#include <sstream>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <utility>              //For std::move
+#include "ics_exceptions.hpp"
+#include "linked_queue.hpp"
+
+
+namespace ics {
+
+
+//A bounded queue between pipeline stages (any number of producer and consumer threads): a
+//  LinkedQueue guarded by one mutex. enqueue waits while the queue holds capacity values (so a
+//  slow consumer pushes back on its producers) and dequeue waits while it is empty, each on its
+//  own condition variable; waiters are counted, so a notify is made only if someone is waiting.
+//The try_ methods never wait; the _for methods wait at most the timeout. dequeue_all_into
+//  removes all the values in one lock/wakeup (an O(1) splice), for consumers that process batches.
+//After close(), enqueue fails (returns 0) and all waiting threads wake; values already in the
+//  queue can still be dequeued, after which dequeue throws EmptyError (and try_ methods fail).
+template<class T> class BlockingQueue {
+  public:
+    //Destructor/Constructors
+    ~BlockingQueue();
+
+    explicit BlockingQueue (int capacity);   //at least 1
+    BlockingQueue          (const BlockingQueue<T>& to_copy) = delete;
+
+
+    //Queries
+    bool empty      () const;
+    int  size       () const;
+    int  capacity   () const;
+    bool closed     () const;
+    std::string str () const; //supplies useful debugging information; contrast to operator <<
+
+
+    //Commands
+    int  enqueue          (const T& element);          //waits while full; returns 0 if closed
+    int  try_enqueue      (const T& element);          //returns 0 if full or closed
+    template <class Rep, class Period>
+    int  try_enqueue_for  (const T& element, const std::chrono::duration<Rep,Period>& timeout);
+
+    T    dequeue          ();                          //waits while empty; throws EmptyError if closed and empty
+    bool try_dequeue      (T& answer);                 //false (and answer unchanged) if empty
+    template <class Rep, class Period>
+    bool try_dequeue_for  (T& answer, const std::chrono::duration<Rep,Period>& timeout);
+    int  dequeue_all_into (LinkedQueue<T>& out);       //waits while empty; returns # moved (0 if closed and empty)
+
+    void close            ();
+    void clear            ();
+
+
+    //Operators
+    BlockingQueue<T>& operator = (const BlockingQueue<T>& rhs) = delete;
+
+    template<class T2>
+    friend std::ostream& operator << (std::ostream& outs, const BlockingQueue<T2>& q);
+
+
+  private:
+    mutable std::mutex       lock;                  //Guards all the data members below
+    std::condition_variable  not_full;              //Producers wait here
+    std::condition_variable  not_empty;             //Consumers wait here
+    LinkedQueue<T>           q;
+    int                      bound;                 //Maximum q.size()
+    bool                     is_closed         = false;
+    int                      waiting_producers = 0;
+    int                      waiting_consumers = 0;
+
+    //Helper methods (called with lock held)
+    void put  (const T& element);                   //Enqueue and wake a consumer
+    T    take ();                                   //Dequeue and wake a producer
+};
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//BlockingQueue class and related definitions
+
+//Destructor/Constructors
+
+template<class T>
+BlockingQueue<T>::~BlockingQueue() {
+}
+
+
+template<class T>
+BlockingQueue<T>::BlockingQueue(int capacity)
+: bound(capacity < 1 ? 1 : capacity) {
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Queries
+
+template<class T>
+bool BlockingQueue<T>::empty() const {
+  std::lock_guard<std::mutex> guard(lock);
+  return q.empty();
+}
+
+
+template<class T>
+int BlockingQueue<T>::size() const {
+  std::lock_guard<std::mutex> guard(lock);
+  return q.size();
+}
+
+
+template<class T>
+int BlockingQueue<T>::capacity() const {
+  return bound;
+}
+
+
+template<class T>
+bool BlockingQueue<T>::closed() const {
+  std::lock_guard<std::mutex> guard(lock);
+  return is_closed;
+}
+
+
+template<class T>
+std::string BlockingQueue<T>::str() const {
+  std::lock_guard<std::mutex> guard(lock);
+  std::ostringstream answer;
+  answer << "BlockingQueue[" << q.str() << "](capacity=" << bound << ",closed=" << is_closed
+         << ",waiting_producers=" << waiting_producers << ",waiting_consumers=" << waiting_consumers << ")";
+  return answer.str();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Commands
+
+template<class T>
+int BlockingQueue<T>::enqueue(const T& element) {
+  std::unique_lock<std::mutex> guard(lock);
+  ++waiting_producers;
+  not_full.wait(guard, [this]{return is_closed || q.size() < bound;});
+  --waiting_producers;
+  if (is_closed)
+    return 0;
+
+  put(element);
+  return 1;
+}
+
+
+template<class T>
+int BlockingQueue<T>::try_enqueue(const T& element) {
+  std::lock_guard<std::mutex> guard(lock);
+  if (is_closed || q.size() >= bound)
+    return 0;
+
+  put(element);
+  return 1;
+}
+
+
+template<class T>
+template<class Rep, class Period>
+int BlockingQueue<T>::try_enqueue_for(const T& element, const std::chrono::duration<Rep,Period>& timeout) {
+  std::unique_lock<std::mutex> guard(lock);
+  ++waiting_producers;
+  bool room = not_full.wait_for(guard, timeout, [this]{return is_closed || q.size() < bound;});
+  --waiting_producers;
+  if (!room || is_closed)
+    return 0;
+
+  put(element);
+  return 1;
+}
+
+
+template<class T>
+T BlockingQueue<T>::dequeue() {
+  std::unique_lock<std::mutex> guard(lock);
+  ++waiting_consumers;
+  not_empty.wait(guard, [this]{return is_closed || !q.empty();});
+  --waiting_consumers;
+  if (q.empty())
+    throw EmptyError("BlockingQueue::dequeue (closed)");
+
+  return take();
+}
+
+
+template<class T>
+bool BlockingQueue<T>::try_dequeue(T& answer) {
+  std::lock_guard<std::mutex> guard(lock);
+  if (q.empty())
+    return false;
+
+  answer = take();
+  return true;
+}
+
+
+template<class T>
+template<class Rep, class Period>
+bool BlockingQueue<T>::try_dequeue_for(T& answer, const std::chrono::duration<Rep,Period>& timeout) {
+  std::unique_lock<std::mutex> guard(lock);
+  ++waiting_consumers;
+  not_empty.wait_for(guard, timeout, [this]{return is_closed || !q.empty();});
+  --waiting_consumers;
+  if (q.empty())
+    return false;
+
+  answer = take();
+  return true;
+}
+
+
+//Splices all the LNs onto out (no copying); frees every slot at once, so wakes all waiting producers
+template<class T>
+int BlockingQueue<T>::dequeue_all_into(LinkedQueue<T>& out) {
+  std::unique_lock<std::mutex> guard(lock);
+  ++waiting_consumers;
+  not_empty.wait(guard, [this]{return is_closed || !q.empty();});
+  --waiting_consumers;
+
+  int count = out.splice_back(std::move(q));
+  if (count != 0 && waiting_producers != 0)
+    not_full.notify_all();
+  return count;
+}
+
+
+template<class T>
+void BlockingQueue<T>::close() {
+  std::lock_guard<std::mutex> guard(lock);
+  is_closed = true;
+  not_full.notify_all();
+  not_empty.notify_all();
+}
+
+
+template<class T>
+void BlockingQueue<T>::clear() {
+  std::lock_guard<std::mutex> guard(lock);
+  q.clear();
+  if (waiting_producers != 0)
+    not_full.notify_all();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Operators
+
+template<class T>
+std::ostream& operator << (std::ostream& outs, const BlockingQueue<T>& q) {
+  std::lock_guard<std::mutex> guard(q.lock);
+  outs << q.q;
+  return outs;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Private helper methods
+
+template<class T>
+void BlockingQueue<T>::put(const T& element) {
+  q.enqueue(element);
+  if (waiting_consumers != 0)
+    not_empty.notify_one();
+}
+
+
+template<class T>
+T BlockingQueue<T>::take() {
+  T answer = q.dequeue();
+  if (waiting_producers != 0)
+    not_full.notify_one();
+  return answer;
+}
+
+}
+
+#endif /* BLOCKING_QUEUE_HPP_ */
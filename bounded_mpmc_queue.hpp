@@ -0,0 +1,248 @@
+#ifndef BOUNDED_MPMC_QUEUE_HPP_
+#define BOUNDED_MPMC_QUEUE_HPP_
+
+#include <string>
+#include <iostream>
+#include <sstream>
+#include <atomic>
+#include <new>                  //For placement new (see enqueue)
+#include <utility>              //For std::move
+#include "ics_exceptions.hpp"
+
+
+namespace ics {
+
+
+//A bounded, lock-free queue for many concurrent producers and consumers (D. Vyukov's design): a
+//  power-of-two circular array of Cells, each with a sequence number saying whose turn it is.
+//  For the enqueue claiming position pos (by CAS on enqueue_pos), Cell pos&mask is free when its
+//  sequence is pos; the enqueue constructs the value and sets sequence to pos+1, which is the
+//  dequeue claiming pos's signal that the value is ready; after moving it out, the dequeue sets
+//  sequence to pos+capacity, freeing the Cell for the enqueue a lap later.
+//No memory is allocated after construction and no memory reclamation is needed; each operation
+//  costs one CAS on a shared position (plus retries under contention).
+//All methods but str/operator << (only when no other thread is using the queue) may be called
+//  concurrently; size/empty are approximate while other threads are enqueueing/dequeueing.
+template<class T> class BoundedMPMCQueue {
+  public:
+    //Destructor/Constructors
+    ~BoundedMPMCQueue();
+
+    explicit BoundedMPMCQueue (int capacity);  //rounded up to a power of two (at least 2)
+    BoundedMPMCQueue          (const BoundedMPMCQueue<T>& to_copy) = delete;
+
+
+    //Queries
+    bool empty      () const;   //Approximate while other threads are enqueueing/dequeueing
+    int  size       () const;   //Approximate while other threads are enqueueing/dequeueing
+    int  capacity   () const;
+    std::string str () const;   //supplies useful debugging information; only when no other thread is using the queue
+
+
+    //Commands
+    int  enqueue     (const T& element);   //returns 0 (and does nothing) if full
+    int  enqueue     (T&& element);
+    T    dequeue     ();                   //throws EmptyError if empty
+    bool try_dequeue (T& answer);          //false (and answer unchanged) if empty
+
+
+    //Operators
+    BoundedMPMCQueue<T>& operator = (const BoundedMPMCQueue<T>& rhs) = delete;
+
+    template<class T2>
+    friend std::ostream& operator << (std::ostream& outs, const BoundedMPMCQueue<T2>& q);
+
+
+  private:
+    static const int cache_line = 64;
+
+    class Cell {
+      public:
+        T& value() {return *reinterpret_cast<T*>(storage);}
+
+        std::atomic<unsigned> sequence;
+        alignas(T) unsigned char storage[sizeof(T)];   //Constructed iff sequence == pos+1 for its pos
+    };
+
+    //Read-only after construction
+    Cell*     cells;
+    unsigned  mask;                                      //capacity-1
+    alignas(cache_line) std::atomic<unsigned> enqueue_pos;  //# enqueues claimed (wrapping)
+    alignas(cache_line) std::atomic<unsigned> dequeue_pos;  //# dequeues claimed (wrapping)
+
+    //Helper methods
+    Cell* claim_enqueue (unsigned& pos);   //The free Cell for pos (now claimed), or nullptr if full
+};
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//BoundedMPMCQueue class and related definitions
+
+//Destructor/Constructors
+
+template<class T>
+BoundedMPMCQueue<T>::~BoundedMPMCQueue() {
+  for (unsigned pos = dequeue_pos.load(); pos != enqueue_pos.load(); ++pos)
+    cells[pos & mask].value().~T();
+  delete[] cells;
+}
+
+
+template<class T>
+BoundedMPMCQueue<T>::BoundedMPMCQueue(int capacity)
+: enqueue_pos(0), dequeue_pos(0) {
+  unsigned length = 2;
+  while ((int)length < capacity && length < (1u << 30))
+    length <<= 1;
+  mask  = length-1;
+  cells = new Cell[length];
+  for (unsigned i=0; i<length; ++i)
+    cells[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Queries
+
+template<class T>
+bool BoundedMPMCQueue<T>::empty() const {
+  return size() == 0;
+}
+
+
+template<class T>
+int BoundedMPMCQueue<T>::size() const {
+  int answer = int(enqueue_pos.load() - dequeue_pos.load());
+  return answer < 0 ? 0 : answer > int(mask+1) ? int(mask+1) : answer;
+}
+
+
+template<class T>
+int BoundedMPMCQueue<T>::capacity() const {
+  return int(mask+1);
+}
+
+
+template<class T>
+std::string BoundedMPMCQueue<T>::str() const {
+  std::ostringstream answer;
+  answer << "BoundedMPMCQueue[";
+
+  unsigned d = dequeue_pos.load(), e = enqueue_pos.load();
+  for (unsigned pos = d; pos != e; ++pos)
+    answer << (pos == d ? "" : ",") << (pos & mask) << ":" << cells[pos & mask].value();
+
+  answer << "](capacity=" << mask+1 << ",dequeue_pos=" << d << ",enqueue_pos=" << e << ")";
+  return answer.str();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Commands
+
+template<class T>
+int BoundedMPMCQueue<T>::enqueue(const T& element) {
+  unsigned pos;
+  Cell* c = claim_enqueue(pos);
+  if (c == nullptr)
+    return 0;
+
+  new (&c->value()) T(element);
+  c->sequence.store(pos+1, std::memory_order_release);
+  return 1;
+}
+
+
+template<class T>
+int BoundedMPMCQueue<T>::enqueue(T&& element) {
+  unsigned pos;
+  Cell* c = claim_enqueue(pos);
+  if (c == nullptr)
+    return 0;
+
+  new (&c->value()) T(std::move(element));
+  c->sequence.store(pos+1, std::memory_order_release);
+  return 1;
+}
+
+
+template<class T>
+T BoundedMPMCQueue<T>::dequeue() {
+  T answer;
+  if (!try_dequeue(answer))
+    throw EmptyError("BoundedMPMCQueue::dequeue");
+  return answer;
+}
+
+
+//A Cell whose sequence is behind pos+1 has not been filled since its last dequeue: empty
+template<class T>
+bool BoundedMPMCQueue<T>::try_dequeue(T& answer) {
+  unsigned pos = dequeue_pos.load(std::memory_order_relaxed);
+  Cell* c;
+  for (;;) {
+    c = &cells[pos & mask];
+    int dif = int(c->sequence.load(std::memory_order_acquire) - (pos+1));
+    if (dif == 0) {
+      if (dequeue_pos.compare_exchange_weak(pos, pos+1, std::memory_order_relaxed))
+        break;
+    }else if (dif < 0)
+      return false;
+    else
+      pos = dequeue_pos.load(std::memory_order_relaxed);
+  }
+
+  answer = std::move(c->value());
+  c->value().~T();
+  c->sequence.store(pos+mask+1, std::memory_order_release);
+  return true;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Operators
+
+template<class T>
+std::ostream& operator << (std::ostream& outs, const BoundedMPMCQueue<T>& q) {
+  outs << "queue[";
+
+  unsigned d = q.dequeue_pos.load(), e = q.enqueue_pos.load();
+  for (unsigned pos = d; pos != e; ++pos)
+    outs << (pos == d ? "" : ",") << q.cells[pos & q.mask].value();
+
+  outs << "]:rear";
+  return outs;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Private helper methods
+
+//A Cell whose sequence is behind pos has not been emptied since the lap before: full
+template<class T>
+auto BoundedMPMCQueue<T>::claim_enqueue(unsigned& pos) -> Cell* {
+  pos = enqueue_pos.load(std::memory_order_relaxed);
+  for (;;) {
+    Cell* c = &cells[pos & mask];
+    int dif = int(c->sequence.load(std::memory_order_acquire) - pos);
+    if (dif == 0) {
+      if (enqueue_pos.compare_exchange_weak(pos, pos+1, std::memory_order_relaxed))
+        return c;
+    }else if (dif < 0)
+      return nullptr;
+    else
+      pos = enqueue_pos.load(std::memory_order_relaxed);
+  }
+}
+
+}
+
+#endif /* BOUNDED_MPMC_QUEUE_HPP_ */
@@ -0,0 +1,524 @@
+#ifndef CALENDAR_PRIORITY_QUEUE_HPP_
+#define CALENDAR_PRIORITY_QUEUE_HPP_
+
+#include <string>
+#include <iostream>
+#include <sstream>
+#include <initializer_list>
+#include <cmath>                //For std::floor
+#include "ics_exceptions.hpp"
+#include "array_stack.hpp"      //See operator <<
+#include "priority_queue_equal.hpp"
+
+
+namespace ics {
+
+
+#ifndef undefinedgtdefined
+#define undefinedgtdefined
+template<class T>
+bool undefinedgt (const T& a, const T& b) {return false;}
+#endif /* undefinedgtdefined */
+
+#ifndef undefinedkeydefined
+#define undefinedkeydefined
+template<class T>
+double undefinedkey (const T& a) {return 0.;}
+#endif /* undefinedkeydefined */
+
+//A calendar queue (R. Brown, 1988) for values whose priorities are times that mostly increase,
+//  as in a discrete-event simulation. Like a desk calendar, it has bucket_count buckets ("days")
+//  each width wide: a value with time t goes in the sorted bucket numbered floor(t/width) mod
+//  bucket_count, so a value a "year" (bucket_count*width) later shares a bucket. dequeue looks
+//  through the buckets from the current day, taking the first value due in that day. Both
+//  enqueue and dequeue are O(1) expected: the bucket count doubles/halves as the size crosses
+//  2*bucket_count or bucket_count/2, and then width is recomputed from the spacing of the next
+//  values to be dequeued, so each day holds few values.
+//Enqueueing a value earlier than the current day moves the current day back to it.
+//
+//Instantiate the templated class supplying tgt(a,b): true, iff a has higher priority than b, and
+//  tkey(a): a's time; a value with a smaller time must have higher priority. Values with the
+//  same time are ordered by tgt; among equal values, FIFO.
+//If tgt/tkey is defaulted to undefinedgt/undefinedkey in the template, then a constructor must
+//  supply cgt/ckey. If both tgt and cgt are supplied, then they must be the same (by ==) function;
+//  likewise for tkey and ckey.
+//If neither is supplied, or both are supplied but different, TemplateFunctionError is raised.
+template<class T, bool (*tgt)(const T& a, const T& b) = undefinedgt<T>, double (*tkey)(const T& a) = undefinedkey<T>>
+class CalendarPriorityQueue {
+  public:
+    typedef bool   (*gtfunc)  (const T& a, const T& b);
+    typedef double (*keyfunc) (const T& a);
+
+    //Destructor/Constructors
+    ~CalendarPriorityQueue();
+
+    CalendarPriorityQueue          (bool (*cgt)(const T& a, const T& b) = undefinedgt<T>, double (*ckey)(const T& a) = undefinedkey<T>);
+    CalendarPriorityQueue          (const CalendarPriorityQueue<T,tgt,tkey>& to_copy);
+    explicit CalendarPriorityQueue (const std::initializer_list<T>& il, bool (*cgt)(const T& a, const T& b) = undefinedgt<T>, double (*ckey)(const T& a) = undefinedkey<T>);
+
+    //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
+    template <class Iterable>
+    explicit CalendarPriorityQueue (const Iterable& i, bool (*cgt)(const T& a, const T& b) = undefinedgt<T>, double (*ckey)(const T& a) = undefinedkey<T>);
+
+
+    //Queries
+    bool empty      () const;
+    int  size       () const;
+    T&   peek       () const;
+    std::string str () const; //supplies useful debugging information; contrast to operator <<
+
+
+    //Commands
+    int  enqueue (const T& element);
+    T    dequeue ();
+    void clear   ();
+
+    //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
+    template <class Iterable>
+    int enqueue_all (const Iterable& i);
+
+
+    //Operators
+    CalendarPriorityQueue<T,tgt,tkey>& operator = (const CalendarPriorityQueue<T,tgt,tkey>& rhs);
+    bool operator == (const CalendarPriorityQueue<T,tgt,tkey>& rhs) const;
+    bool operator != (const CalendarPriorityQueue<T,tgt,tkey>& rhs) const;
+
+    template<class T2, bool (*gt2)(const T2& a, const T2& b), double (*key2)(const T2& a)>
+    friend std::ostream& operator << (std::ostream& outs, const CalendarPriorityQueue<T2,gt2,key2>& pq);
+
+
+  private:
+    class LN {
+      public:
+        LN ()                      {}
+        LN (const LN& ln)          : value(ln.value), next(ln.next){}
+        LN (T v,  LN* n = nullptr) : value(v), next(n){}
+
+        T   value;
+        LN* next = nullptr;
+    };
+
+    static const int min_buckets = 2;
+    static const int samples     = 25;     //# of values whose spacing sets width (see resize)
+
+    bool   (*gt)  (const T& a, const T& b); // The gt used by enqueue (from template or constructor)
+    double (*key) (const T& a);             // The key used by enqueue (from template or constructor)
+    LN**      bucket;                       // bucket[i]: sorted list of values, or nullptr
+    LN**      tail;                         // tail[i]: last LN in bucket[i], or nullptr
+    int       bucket_count = min_buckets;
+    double    width        = 1.;
+    long long day          = 0;             //floor(time/width) of the day dequeue looks at first
+    int       used         = 0;
+    int       mod_count    = 0;             //For sensing concurrent modification
+
+
+    //Helper methods
+    long long day_of      (const T& v) const;   //floor(key(v)/width)
+    int       bucket_of   (long long d) const;  //d mod bucket_count (non-negative)
+    int       next_bucket (long long& d) const; //bucket holding the next value to dequeue; d becomes its day
+    int       highest_bucket () const;          //bucket whose first value has the highest priority
+    void      link        (LN* n);              //Insert n into its bucket (after values not lower priority): O(1) if not higher than its tail
+    void      resize      (int new_count);
+    void      allocate    (int new_count);      //bucket_count = new_count, all buckets empty
+    void      delete_buckets ();
+    void      copy_buckets   (const CalendarPriorityQueue<T,tgt,tkey>& from);
+};
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//CalendarPriorityQueue class and related definitions
+
+//Destructor/Constructors
+
+template<class T, bool (*tgt)(const T& a, const T& b), double (*tkey)(const T& a)>
+CalendarPriorityQueue<T,tgt,tkey>::~CalendarPriorityQueue() {
+  delete_buckets();
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), double (*tkey)(const T& a)>
+CalendarPriorityQueue<T,tgt,tkey>::CalendarPriorityQueue(bool (*cgt)(const T& a, const T& b), double (*ckey)(const T& a))
+: gt(tgt != (gtfunc)undefinedgt<T> ? tgt : cgt), key(tkey != (keyfunc)undefinedkey<T> ? tkey : ckey) {
+  if (gt == (gtfunc)undefinedgt<T> || key == (keyfunc)undefinedkey<T>)
+    throw TemplateFunctionError("CalendarPriorityQueue::default constructor: neither specified");
+  if ((tgt != (gtfunc)undefinedgt<T> && cgt != (gtfunc)undefinedgt<T> && tgt != cgt) ||
+      (tkey != (keyfunc)undefinedkey<T> && ckey != (keyfunc)undefinedkey<T> && tkey != ckey))
+    throw TemplateFunctionError("CalendarPriorityQueue::default constructor: both specified and different");
+
+  allocate(min_buckets);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), double (*tkey)(const T& a)>
+CalendarPriorityQueue<T,tgt,tkey>::CalendarPriorityQueue(const CalendarPriorityQueue<T,tgt,tkey>& to_copy)
+: gt(to_copy.gt), key(to_copy.key) {
+  allocate(to_copy.bucket_count);
+  copy_buckets(to_copy);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), double (*tkey)(const T& a)>
+CalendarPriorityQueue<T,tgt,tkey>::CalendarPriorityQueue(const std::initializer_list<T>& il, bool (*cgt)(const T& a, const T& b), double (*ckey)(const T& a))
+: gt(tgt != (gtfunc)undefinedgt<T> ? tgt : cgt), key(tkey != (keyfunc)undefinedkey<T> ? tkey : ckey) {
+  if (gt == (gtfunc)undefinedgt<T> || key == (keyfunc)undefinedkey<T>)
+    throw TemplateFunctionError("CalendarPriorityQueue::initializer_list constructor: neither specified");
+  if ((tgt != (gtfunc)undefinedgt<T> && cgt != (gtfunc)undefinedgt<T> && tgt != cgt) ||
+      (tkey != (keyfunc)undefinedkey<T> && ckey != (keyfunc)undefinedkey<T> && tkey != ckey))
+    throw TemplateFunctionError("CalendarPriorityQueue::initializer_list constructor: both specified and different");
+
+  allocate(min_buckets);
+  for (const T& pq_elem : il)
+    enqueue(pq_elem);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), double (*tkey)(const T& a)>
+template<class Iterable>
+CalendarPriorityQueue<T,tgt,tkey>::CalendarPriorityQueue(const Iterable& i, bool (*cgt)(const T& a, const T& b), double (*ckey)(const T& a))
+: gt(tgt != (gtfunc)undefinedgt<T> ? tgt : cgt), key(tkey != (keyfunc)undefinedkey<T> ? tkey : ckey) {
+  if (gt == (gtfunc)undefinedgt<T> || key == (keyfunc)undefinedkey<T>)
+    throw TemplateFunctionError("CalendarPriorityQueue::Iterable constructor: neither specified");
+  if ((tgt != (gtfunc)undefinedgt<T> && cgt != (gtfunc)undefinedgt<T> && tgt != cgt) ||
+      (tkey != (keyfunc)undefinedkey<T> && ckey != (keyfunc)undefinedkey<T> && tkey != ckey))
+    throw TemplateFunctionError("CalendarPriorityQueue::Iterable constructor: both specified and different");
+
+  allocate(min_buckets);
+  for (const T& pq_elem : i)
+    enqueue(pq_elem);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Queries
+
+template<class T, bool (*tgt)(const T& a, const T& b), double (*tkey)(const T& a)>
+bool CalendarPriorityQueue<T,tgt,tkey>::empty() const {
+  return used == 0;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), double (*tkey)(const T& a)>
+int CalendarPriorityQueue<T,tgt,tkey>::size() const {
+  return used;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), double (*tkey)(const T& a)>
+T& CalendarPriorityQueue<T,tgt,tkey>::peek () const {
+  if (empty())
+    throw EmptyError("CalendarPriorityQueue::peek");
+
+  long long d = day;
+  return bucket[next_bucket(d)]->value;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), double (*tkey)(const T& a)>
+std::string CalendarPriorityQueue<T,tgt,tkey>::str() const {
+  std::ostringstream answer;
+  answer << "CalendarPriorityQueue[";
+
+  for (int i=0; i<bucket_count; ++i) {
+    answer << (i == 0 ? "" : ",") << i << ":";
+    for (LN* p = bucket[i]; p != nullptr; p = p->next)
+      answer << (p == bucket[i] ? "" : "->") << p->value;
+  }
+
+  answer << "](bucket_count=" << bucket_count << ",width=" << width << ",day=" << day
+         << ",used=" << used << ",mod_count=" << mod_count << ")";
+  return answer.str();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Commands
+
+template<class T, bool (*tgt)(const T& a, const T& b), double (*tkey)(const T& a)>
+int CalendarPriorityQueue<T,tgt,tkey>::enqueue(const T& element) {
+  LN* n = new LN(element);
+  link(n);
+  long long d = day_of(element);
+  if (d < day)
+    day = d;
+
+  ++used;
+  ++mod_count;
+  if (used > 2*bucket_count)
+    resize(2*bucket_count);
+  return 1;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), double (*tkey)(const T& a)>
+T CalendarPriorityQueue<T,tgt,tkey>::dequeue() {
+  if (empty())
+    throw EmptyError("CalendarPriorityQueue::dequeue");
+
+  int b = next_bucket(day);
+  LN* to_delete = bucket[b];
+  T to_return = to_delete->value;
+  bucket[b] = to_delete->next;
+  if (bucket[b] == nullptr)
+    tail[b] = nullptr;
+  delete to_delete;
+
+  --used;
+  ++mod_count;
+  if (used < bucket_count/2 && bucket_count > min_buckets)
+    resize(bucket_count/2);
+  return to_return;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), double (*tkey)(const T& a)>
+void CalendarPriorityQueue<T,tgt,tkey>::clear() {
+  delete_buckets();
+  allocate(min_buckets);
+  width = 1.;
+  day   = 0;
+  used  = 0;
+  ++mod_count;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), double (*tkey)(const T& a)>
+template <class Iterable>
+int CalendarPriorityQueue<T,tgt,tkey>::enqueue_all (const Iterable& i) {
+  int count = 0;
+  for (const T& v : i)
+     count += enqueue(v);
+
+  return count;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Operators
+
+template<class T, bool (*tgt)(const T& a, const T& b), double (*tkey)(const T& a)>
+CalendarPriorityQueue<T,tgt,tkey>& CalendarPriorityQueue<T,tgt,tkey>::operator = (const CalendarPriorityQueue<T,tgt,tkey>& rhs) {
+  if (this == &rhs)
+    return *this;
+
+  gt  = rhs.gt;   // if tgt != nullptr, gts are already equal (or compiler error)
+  key = rhs.key;
+  delete_buckets();
+  allocate(rhs.bucket_count);
+  copy_buckets(rhs);
+
+  ++mod_count;
+  return *this;
+}
+
+
+//Equal if same gt/key and the same values (see priority_queue_equal)
+template<class T, bool (*tgt)(const T& a, const T& b), double (*tkey)(const T& a)>
+bool CalendarPriorityQueue<T,tgt,tkey>::operator == (const CalendarPriorityQueue<T,tgt,tkey>& rhs) const {
+  if (this == &rhs)
+    return true;
+  if (gt != rhs.gt || key != rhs.key)
+    return false;
+  if (used != rhs.size())
+    return false;
+
+  //Values of equal priority may be in any order (see priority_queue_equal)
+  const T** l = new const T*[used];
+  const T** r = new const T*[used];
+  for (int b=0, i=0; b<bucket_count; ++b)
+    for (LN* p = bucket[b]; p != nullptr; p = p->next)
+      l[i++] = &p->value;
+  for (int b=0, i=0; b<rhs.bucket_count; ++b)
+    for (LN* p = rhs.bucket[b]; p != nullptr; p = p->next)
+      r[i++] = &p->value;
+  bool answer = priority_queue_equal(l,r,used,gt);
+
+  delete[] l;
+  delete[] r;
+  return answer;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), double (*tkey)(const T& a)>
+bool CalendarPriorityQueue<T,tgt,tkey>::operator != (const CalendarPriorityQueue<T,tgt,tkey>& rhs) const {
+  return !(*this == rhs);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), double (*tkey)(const T& a)>
+std::ostream& operator << (std::ostream& outs, const CalendarPriorityQueue<T,tgt,tkey>& p) {
+  outs << "priority_queue[";
+
+  if (!p.empty()) {
+    CalendarPriorityQueue<T,tgt,tkey> temp(p);
+    ArrayStack<T> st;
+    while (!temp.empty())
+      st.push(temp.dequeue());
+    outs << st.pop();
+    while (!st.empty())
+      outs << "," << st.pop();
+  }
+
+  outs << "]:highest";
+  return outs;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Private helper methods
+
+template<class T, bool (*tgt)(const T& a, const T& b), double (*tkey)(const T& a)>
+long long CalendarPriorityQueue<T,tgt,tkey>::day_of(const T& v) const {
+  return (long long)std::floor(key(v)/width);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), double (*tkey)(const T& a)>
+int CalendarPriorityQueue<T,tgt,tkey>::bucket_of(long long d) const {
+  int b = int(d % bucket_count);
+  return b < 0 ? b+bucket_count : b;
+}
+
+
+//Look through one year of days from d for a bucket whose first value is due that day; if there
+//  is none (the next value is more than a year away), find the highest priority first value
+template<class T, bool (*tgt)(const T& a, const T& b), double (*tkey)(const T& a)>
+int CalendarPriorityQueue<T,tgt,tkey>::next_bucket(long long& d) const {
+  for (int i=0; i<bucket_count; ++i, ++d) {
+    int b = bucket_of(d);
+    if (bucket[b] != nullptr && day_of(bucket[b]->value) <= d)
+      return b;
+  }
+
+  int best = highest_bucket();
+  d = day_of(bucket[best]->value);
+  return best;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), double (*tkey)(const T& a)>
+int CalendarPriorityQueue<T,tgt,tkey>::highest_bucket() const {
+  int best = -1;
+  for (int b=0; b<bucket_count; ++b)
+    if (bucket[b] != nullptr && (best == -1 || gt(bucket[b]->value,bucket[best]->value)))
+      best = b;
+  return best;
+}
+
+
+//Simultaneous (or increasing) times arrive in order, so appending after the tail is the common case
+template<class T, bool (*tgt)(const T& a, const T& b), double (*tkey)(const T& a)>
+void CalendarPriorityQueue<T,tgt,tkey>::link(LN* n) {
+  int  b = bucket_of(day_of(n->value));
+  LN** p = (tail[b] != nullptr && !gt(n->value,tail[b]->value) ? &tail[b]->next : &bucket[b]);
+  while (*p != nullptr && !gt(n->value,(*p)->value))
+    p = &(*p)->next;
+  n->next = *p;
+  *p = n;
+  if (n->next == nullptr)
+    tail[b] = n;
+}
+
+
+//New width: 3 times the average gap between the times of the next (up to) samples values to
+//  dequeue, ignoring gaps more than twice the average (which would make days too long)
+template<class T, bool (*tgt)(const T& a, const T& b), double (*tkey)(const T& a)>
+void CalendarPriorityQueue<T,tgt,tkey>::resize(int new_count) {
+  //Detach the next n values, then push them back on the front of their buckets (in reverse
+  //  order, as each is first among its bucket's values), so FIFO order among equals is kept
+  int n = used < samples ? used : samples;
+  if (n >= 2) {
+    LN** sample = new LN*[n];
+    long long d = day;
+    for (int i=0; i<n; ++i) {
+      int b = next_bucket(d);
+      sample[i] = bucket[b];
+      bucket[b] = sample[i]->next;
+      if (bucket[b] == nullptr)
+        tail[b] = nullptr;
+    }
+    double average = (key(sample[n-1]->value) - key(sample[0]->value)) / (n-1);
+    double total   = 0.;
+    int    gaps    = 0;
+    for (int i=1; i<n; ++i) {
+      double gap = key(sample[i]->value) - key(sample[i-1]->value);
+      if (gap <= 2*average) {
+        total += gap;
+        ++gaps;
+      }
+    }
+    for (int i=n-1; i>=0; --i) {
+      int b = bucket_of(day_of(sample[i]->value));
+      sample[i]->next = bucket[b];
+      bucket[b] = sample[i];
+      if (tail[b] == nullptr)
+        tail[b] = sample[i];
+    }
+    delete[] sample;
+    if (gaps != 0 && total > 0.)
+      width = 3*total/gaps;
+  }
+
+  //Relink every value into the new buckets
+  LN** old_bucket = bucket;
+  int  old_count  = bucket_count;
+  delete[] tail;
+  allocate(new_count);
+  for (int b=0; b<old_count; ++b)
+    for (LN* p = old_bucket[b]; p != nullptr; /*see body*/) {
+      LN* to_link = p;
+      p = p->next;
+      link(to_link);
+    }
+  delete[] old_bucket;
+
+  if (used != 0)     //day was counted in the old width: restart from the day of the next value
+    day = day_of(bucket[highest_bucket()]->value);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), double (*tkey)(const T& a)>
+void CalendarPriorityQueue<T,tgt,tkey>::allocate(int new_count) {
+  bucket_count = new_count;
+  bucket = new LN*[bucket_count];
+  tail   = new LN*[bucket_count];
+  for (int b=0; b<bucket_count; ++b)
+    bucket[b] = tail[b] = nullptr;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), double (*tkey)(const T& a)>
+void CalendarPriorityQueue<T,tgt,tkey>::delete_buckets() {
+  for (int b=0; b<bucket_count; ++b)
+    for (LN* p = bucket[b]; p != nullptr; /*see body*/) {
+      LN* to_delete = p;
+      p = p->next;
+      delete to_delete;
+    }
+  delete[] bucket;
+  delete[] tail;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), double (*tkey)(const T& a)>
+void CalendarPriorityQueue<T,tgt,tkey>::copy_buckets(const CalendarPriorityQueue<T,tgt,tkey>& from) {
+  for (int b=0; b<bucket_count; ++b) {
+    LN** to = &bucket[b];
+    for (LN* p = from.bucket[b]; p != nullptr; p = p->next, to = &(*to)->next)
+      tail[b] = *to = new LN(p->value);
+  }
+  width = from.width;
+  day   = from.day;
+  used  = from.used;
+}
+
+}
+
+#endif /* CALENDAR_PRIORITY_QUEUE_HPP_ */
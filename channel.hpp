@@ -0,0 +1,470 @@
+#ifndef CHANNEL_HPP_
+#define CHANNEL_HPP_
+
+#if !defined(__cpp_impl_coroutine)
+#error "channel.hpp needs C++20 coroutines (compile with -std=c++20)"
+#endif
+
+#include <string>
+#include <iostream>
+#include <sstream>
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>              //For std::move
+#include "ics_exceptions.hpp"
+#include "linked_queue.hpp"
+
+
+namespace ics {
+
+
+class Executor;
+
+//The return type of a coroutine run by an Executor: it starts suspended, runs when spawned, and
+//  its frame is destroyed when it finishes. An AsyncTask that is never spawned destroys its frame.
+class AsyncTask {
+  public:
+    class promise_type {
+      public:
+        AsyncTask           get_return_object   ()          {return AsyncTask(std::coroutine_handle<promise_type>::from_promise(*this));}
+        std::suspend_always initial_suspend     ()          {return {};}
+        std::suspend_never  final_suspend       () noexcept {return {};}
+        void                return_void         ()          {}
+        void                unhandled_exception ();          //Kept by the Executor: run() rethrows it
+
+        Executor* executor = nullptr;
+    };
+
+    ~AsyncTask()                                  {if (h) h.destroy();}
+    AsyncTask(AsyncTask&& other)                  : h(other.h) {other.h = nullptr;}
+    AsyncTask(const AsyncTask& to_copy)           = delete;
+    AsyncTask& operator = (const AsyncTask& rhs)  = delete;
+
+  private:
+    friend class Executor;
+    explicit AsyncTask(std::coroutine_handle<promise_type> h) : h(h) {}
+
+    std::coroutine_handle<promise_type> h;
+};
+
+
+//A single-threaded executor: a LinkedQueue of coroutines ready to resume, run in FIFO order by
+//  run() (on the calling thread) until none is ready.
+class Executor {
+  public:
+    //Destructor/Constructors
+    ~Executor();
+    Executor();
+    Executor(const Executor& to_copy) = delete;
+
+    //Queries
+    bool empty      () const;
+    std::string str () const; //supplies useful debugging information
+
+    //Commands
+    void spawn    (AsyncTask&& t);
+    void schedule (std::coroutine_handle<> h);
+    int  run      ();          //Resume ready coroutines until none; returns # resumed; rethrows a coroutine's exception
+
+    Executor& operator = (const Executor& rhs) = delete;
+
+  private:
+    friend class AsyncTask::promise_type;
+    LinkedQueue<std::coroutine_handle<>> ready;
+    std::exception_ptr                   error;   //First exception escaping a spawned coroutine
+};
+
+
+//A queue whose values coroutines co_await, all running on one Executor (one thread). Bounded
+//  (capacity >= 1) or unbounded (capacity < 1):
+//  int n = co_await c.enqueue(v);  //suspends while full; 0 if the channel is (or becomes) closed
+//  T   v = co_await c.dequeue();   //suspends while empty; throws EmptyError if closed and empty
+//When a value is enqueued while a consumer is suspended, it is handed straight to the consumer,
+//  and the producer resumes the consumer by symmetric transfer (the producer is scheduled on
+//  the Executor to continue later): the handoff costs a resumption, not a trip through the queue.
+//A consumer that makes room for a suspended producer moves its value into the queue and
+//  schedules it. Producers and consumers are each resumed in FIFO order. Destroying a Channel
+//  destroys the coroutines still suspended on it (as destroying an Executor destroys the ready ones).
+template<class T> class Channel {
+  public:
+    class EnqueueAwaiter;
+    class DequeueAwaiter;
+
+    //Destructor/Constructors
+    ~Channel();
+
+    explicit Channel (Executor& executor, int capacity = 0);
+    Channel          (const Channel<T>& to_copy) = delete;
+
+
+    //Queries
+    bool empty      () const;
+    int  size       () const;
+    int  capacity   () const;     //< 1 means unbounded
+    bool closed     () const;
+    std::string str () const; //supplies useful debugging information; contrast to operator <<
+
+
+    //Commands
+    EnqueueAwaiter enqueue     (T element);
+    DequeueAwaiter dequeue     ();
+    int            try_enqueue (const T& element);   //returns 0 if full or closed (never suspends)
+    bool           try_dequeue (T& answer);          //false (and answer unchanged) if empty
+    void           close       ();                   //Resumes all suspended producers (0) and consumers (EmptyError)
+
+
+    //Operators
+    Channel<T>& operator = (const Channel<T>& rhs) = delete;
+
+    template<class T2>
+    friend std::ostream& operator << (std::ostream& outs, const Channel<T2>& c);
+
+
+    class EnqueueAwaiter {
+      public:
+        bool                    await_ready   ();
+        std::coroutine_handle<> await_suspend (std::coroutine_handle<> h);
+        int                     await_resume  ();
+
+      private:
+        friend class Channel<T>;
+        EnqueueAwaiter(Channel<T>* c, T&& v) : channel(c), value(std::move(v)) {}
+
+        Channel<T>*             channel;
+        T                       value;
+        std::coroutine_handle<> waiting;          //This producer, while suspended
+        int                     result = 0;
+    };
+
+    class DequeueAwaiter {
+      public:
+        bool await_ready   ();
+        void await_suspend (std::coroutine_handle<> h);
+        T    await_resume  ();
+
+      private:
+        friend class Channel<T>;
+        explicit DequeueAwaiter(Channel<T>* c) : channel(c) {}
+
+        Channel<T>*             channel;
+        std::optional<T>        value;            //Set when a value is taken (or handed over)
+        std::coroutine_handle<> waiting;          //This consumer, while suspended
+    };
+
+
+  private:
+    Executor&                    executor;
+    LinkedQueue<T>               values;
+    LinkedQueue<EnqueueAwaiter*> producers;       //Suspended because the channel was full
+    LinkedQueue<DequeueAwaiter*> consumers;       //Suspended because the channel was empty
+    int                          bound;
+    bool                         is_closed = false;
+
+    //Helper methods
+    bool full        () const;
+    void refill_from_producer ();                 //After a dequeue, move a suspended producer's value in
+};
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//AsyncTask/Executor class and related definitions
+
+inline void AsyncTask::promise_type::unhandled_exception() {
+  if (executor != nullptr && !executor->error)
+    executor->error = std::current_exception();
+}
+
+
+inline Executor::~Executor() {
+  while (!ready.empty())
+    ready.dequeue().destroy();
+}
+
+
+inline Executor::Executor() {
+}
+
+
+inline bool Executor::empty() const {
+  return ready.empty();
+}
+
+
+inline std::string Executor::str() const {
+  std::ostringstream answer;
+  answer << "Executor[ready=" << ready.size() << "]";
+  return answer.str();
+}
+
+
+inline void Executor::spawn(AsyncTask&& t) {
+  t.h.promise().executor = this;
+  ready.enqueue(t.h);
+  t.h = nullptr;
+}
+
+
+inline void Executor::schedule(std::coroutine_handle<> h) {
+  ready.enqueue(h);
+}
+
+
+inline int Executor::run() {
+  int count = 0;
+  while (!ready.empty()) {
+    ready.dequeue().resume();
+    ++count;
+  }
+
+  if (error) {
+    std::exception_ptr e = error;
+    error = nullptr;
+    std::rethrow_exception(e);
+  }
+  return count;
+}
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Channel class and related definitions
+
+//Destructor/Constructors
+
+//Coroutines still suspended on the channel are referred to only by producers/consumers (their
+//  AsyncTasks gave up their frames when spawned), so destroy their frames here
+template<class T>
+Channel<T>::~Channel() {
+  while (!producers.empty()) {
+    std::coroutine_handle<> h = producers.dequeue()->waiting;
+    h.destroy();
+  }
+  while (!consumers.empty()) {
+    std::coroutine_handle<> h = consumers.dequeue()->waiting;
+    h.destroy();
+  }
+}
+
+
+template<class T>
+Channel<T>::Channel(Executor& executor, int capacity)
+: executor(executor), bound(capacity) {
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Queries
+
+template<class T>
+bool Channel<T>::empty() const {
+  return values.empty();
+}
+
+
+template<class T>
+int Channel<T>::size() const {
+  return values.size();
+}
+
+
+template<class T>
+int Channel<T>::capacity() const {
+  return bound;
+}
+
+
+template<class T>
+bool Channel<T>::closed() const {
+  return is_closed;
+}
+
+
+template<class T>
+std::string Channel<T>::str() const {
+  std::ostringstream answer;
+  answer << "Channel[" << values.str() << "](capacity=" << bound << ",closed=" << is_closed
+         << ",producers=" << producers.size() << ",consumers=" << consumers.size() << ")";
+  return answer.str();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Commands
+
+template<class T>
+auto Channel<T>::enqueue(T element) -> EnqueueAwaiter {
+  return EnqueueAwaiter(this,std::move(element));
+}
+
+
+template<class T>
+auto Channel<T>::dequeue() -> DequeueAwaiter {
+  return DequeueAwaiter(this);
+}
+
+
+template<class T>
+int Channel<T>::try_enqueue(const T& element) {
+  if (is_closed || full())
+    return 0;
+
+  if (!consumers.empty()) {             //Hand over: the consumer resumes when the Executor gets to it
+    DequeueAwaiter* c = consumers.dequeue();
+    c->value.emplace(element);
+    executor.schedule(c->waiting);
+  }else
+    values.enqueue(element);
+  return 1;
+}
+
+
+template<class T>
+bool Channel<T>::try_dequeue(T& answer) {
+  if (values.empty())
+    return false;
+
+  answer = values.dequeue();
+  refill_from_producer();
+  return true;
+}
+
+
+template<class T>
+void Channel<T>::close() {
+  is_closed = true;
+  while (!producers.empty()) {
+    EnqueueAwaiter* p = producers.dequeue();
+    p->result = 0;
+    executor.schedule(p->waiting);
+  }
+  while (!consumers.empty())
+    executor.schedule(consumers.dequeue()->waiting);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Operators
+
+template<class T>
+std::ostream& operator << (std::ostream& outs, const Channel<T>& c) {
+  outs << c.values;
+  return outs;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Private helper methods
+
+template<class T>
+bool Channel<T>::full() const {
+  return bound >= 1 && values.size() >= bound;
+}
+
+
+template<class T>
+void Channel<T>::refill_from_producer() {
+  if (producers.empty() || full())
+    return;
+
+  EnqueueAwaiter* p = producers.dequeue();
+  values.enqueue(std::move(p->value));
+  p->result = 1;
+  executor.schedule(p->waiting);
+}
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//EnqueueAwaiter class definitions
+
+//Ready (no suspension) if closed or if the value fits in the queue with no consumer waiting for it
+template<class T>
+bool Channel<T>::EnqueueAwaiter::await_ready() {
+  if (channel->is_closed) {
+    result = 0;
+    return true;
+  }
+  if (channel->consumers.empty() && !channel->full()) {
+    channel->values.enqueue(std::move(value));
+    result = 1;
+    return true;
+  }
+  return false;
+}
+
+
+//Either hand the value to the first suspended consumer and transfer to it (scheduling this
+//  producer to continue later), or (full) wait for a consumer to make room
+template<class T>
+std::coroutine_handle<> Channel<T>::EnqueueAwaiter::await_suspend(std::coroutine_handle<> h) {
+  waiting = h;
+  if (!channel->consumers.empty()) {
+    DequeueAwaiter* c = channel->consumers.dequeue();
+    c->value.emplace(std::move(value));
+    result = 1;
+    channel->executor.schedule(h);
+    return c->waiting;
+  }
+
+  channel->producers.enqueue(this);
+  return std::noop_coroutine();
+}
+
+
+template<class T>
+int Channel<T>::EnqueueAwaiter::await_resume() {
+  return result;
+}
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//DequeueAwaiter class definitions
+
+//Ready (no suspension) if a value can be taken now, or if closed (then await_resume throws)
+template<class T>
+bool Channel<T>::DequeueAwaiter::await_ready() {
+  if (!channel->values.empty()) {
+    value.emplace(channel->values.dequeue());
+    channel->refill_from_producer();
+    return true;
+  }
+  return channel->is_closed;
+}
+
+
+template<class T>
+void Channel<T>::DequeueAwaiter::await_suspend(std::coroutine_handle<> h) {
+  waiting = h;
+  channel->consumers.enqueue(this);
+}
+
+
+template<class T>
+T Channel<T>::DequeueAwaiter::await_resume() {
+  if (!value)
+    throw EmptyError("Channel::dequeue (closed)");
+  return std::move(*value);
+}
+
+}
+
+#endif /* CHANNEL_HPP_ */
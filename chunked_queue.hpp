@@ -0,0 +1,659 @@
+#ifndef CHUNKED_QUEUE_HPP_
+#define CHUNKED_QUEUE_HPP_
+
+#include <string>
+#include <iostream>
+#include <sstream>
+#include <initializer_list>
+#include <new>                  //For placement new (see enqueue)
+#include <utility>              //For std::move
+#include "ics_exceptions.hpp"
+#include "fast_range.hpp"
+
+
+namespace ics {
+
+
+//A LinkedQueue whose nodes (Blocks) each hold up to chunk values, so enqueue/dequeue allocate
+//  and free once per chunk values (not once per value) and values are contiguous in memory.
+//Each Block stores its values in value[begin..end): enqueue appends at the rear Block's end,
+//  dequeue removes at the front Block's begin, and Iterator::erase shifts the later values of
+//  its Block down by one. Emptied Blocks are kept (up to max_spare of them) on a free list, for
+//  reuse by enqueue, so a queue whose size stays about the same allocates nothing.
+template<class T, int chunk = 64> class ChunkedQueue {
+  public:
+    //Destructor/Constructors
+    ~ChunkedQueue();
+
+    ChunkedQueue          ();
+    ChunkedQueue          (const ChunkedQueue<T,chunk>& to_copy);
+    explicit ChunkedQueue (const std::initializer_list<T>& il);
+
+    //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
+    template <class Iterable>
+    explicit ChunkedQueue (const Iterable& i);
+
+
+    //Queries
+    bool empty      () const;
+    int  size       () const;
+    T&   peek       () const;
+    std::string str () const; //supplies useful debugging information; contrast to operator <<
+
+
+    //Commands
+    int  enqueue (const T& element);
+    T    dequeue ();
+    void clear   ();
+
+    //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
+    template <class Iterable>
+    int enqueue_all (const Iterable& i);
+
+
+    //Operators
+    ChunkedQueue<T,chunk>& operator = (const ChunkedQueue<T,chunk>& rhs);
+    bool operator == (const ChunkedQueue<T,chunk>& rhs) const;
+    bool operator != (const ChunkedQueue<T,chunk>& rhs) const;
+
+    template<class T2, int chunk2>
+    friend std::ostream& operator << (std::ostream& outs, const ChunkedQueue<T2,chunk2>& q);
+
+
+
+  private:
+    class Block;
+
+  public:
+    class Iterator {
+      public:
+        //Private constructor called in begin/end, which are friends of ChunkedQueue<T,chunk>
+        ~Iterator();
+        T           erase();
+        std::string str  () const;
+        ChunkedQueue<T,chunk>::Iterator& operator ++ ();
+        ChunkedQueue<T,chunk>::Iterator  operator ++ (int);
+        bool operator == (const ChunkedQueue<T,chunk>::Iterator& rhs) const;
+        bool operator != (const ChunkedQueue<T,chunk>::Iterator& rhs) const;
+        T& operator *  () const;
+        T* operator -> () const;
+        friend std::ostream& operator << (std::ostream& outs, const ChunkedQueue<T,chunk>::Iterator& i) {
+          outs << i.str(); //Use the same meaning as the debugging .str() method
+          return outs;
+        }
+        friend Iterator ChunkedQueue<T,chunk>::begin () const;
+        friend Iterator ChunkedQueue<T,chunk>::end   () const;
+
+      private:
+        //If can_erase is false, current indexes the "next" value (must ++ to reach it)
+        Block*                 prev = nullptr;  //if nullptr, current is in the front Block
+        Block*                 current;         //current == prev->next (if prev != nullptr)
+        int                    index;           //current->value(index); 0 when current == nullptr
+        ChunkedQueue<T,chunk>* ref_queue;
+        int                    expected_mod_count;
+        bool                   can_erase = true;
+
+        //Called in friends begin/end
+        Iterator(ChunkedQueue<T,chunk>* iterate_over, Block* initial);
+        void advance();   //To the next value (maybe in the next Block)
+    };
+
+
+    Iterator begin () const;
+    Iterator end   () const;
+
+
+    //Unchecked iterator for hot loops: no mod_count/dynamic_cast checks and no erase.
+    //The queue must not be changed while one is in use; see ics::fast above for a "for-each" loop
+    class FastIterator {
+      public:
+        ChunkedQueue<T,chunk>::FastIterator& operator ++ ();
+        bool operator == (const ChunkedQueue<T,chunk>::FastIterator& rhs) const;
+        bool operator != (const ChunkedQueue<T,chunk>::FastIterator& rhs) const;
+        T& operator *  () const;
+        T* operator -> () const;
+
+        friend FastIterator ChunkedQueue<T,chunk>::fast_begin () const;
+        friend FastIterator ChunkedQueue<T,chunk>::fast_end   () const;
+
+      private:
+        Block* current;
+        int    index;
+
+        //Called in friends fast_begin/fast_end
+        FastIterator(Block* initial);
+    };
+
+
+    FastIterator fast_begin () const;
+    FastIterator fast_end   () const;
+
+
+  private:
+    //Only value(begin..end) are constructed; storage is raw so T needs no default constructor
+    class Block {
+      public:
+        T& value(int i) {return reinterpret_cast<T*>(storage)[i];}
+
+        Block* next  = nullptr;
+        int    begin = 0;
+        int    end   = 0;
+        alignas(T) unsigned char storage[chunk*sizeof(T)];
+    };
+
+    static const int max_spare = 4;  //Most emptied Blocks kept for reuse (the rest are deleted)
+
+    Block* front     = nullptr;
+    Block* rear      = nullptr;
+    Block* spare     = nullptr;      //Free list (linked by next) of emptied Blocks
+    int    spares    = 0;            //Number of Blocks on spare
+    int    used      = 0;            //Cache for number of values in all Blocks
+    int    mod_count = 0;            //For sensing concurrent modification
+
+    //Helper methods
+    Block* new_block     ();         //From spare if possible; begin = end = 0
+    void   recycle_block (Block* b); //b's values must already be destroyed
+    void   delete_list   ();         //Destroy all values, recycle/delete all Blocks, set front/rear to nullptr
+};
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//ChunkedQueue class and related definitions
+
+//Destructor/Constructors
+
+template<class T, int chunk>
+ChunkedQueue<T,chunk>::~ChunkedQueue() {
+  delete_list();
+  for (Block* p = spare; p != nullptr; /*see body*/) {
+    Block* to_delete = p;
+    p = p->next;
+    delete to_delete;
+  }
+}
+
+
+template<class T, int chunk>
+ChunkedQueue<T,chunk>::ChunkedQueue() {
+  static_assert(chunk > 0, "ChunkedQueue: chunk must be positive");
+}
+
+
+template<class T, int chunk>
+ChunkedQueue<T,chunk>::ChunkedQueue(const ChunkedQueue<T,chunk>& to_copy) {
+  for (Block* b = to_copy.front; b != nullptr; b = b->next)
+    for (int i = b->begin; i < b->end; ++i)
+      enqueue(b->value(i));
+}
+
+
+template<class T, int chunk>
+ChunkedQueue<T,chunk>::ChunkedQueue(const std::initializer_list<T>& il) {
+  for (const T& q_elem : il)
+    enqueue(q_elem);
+}
+
+
+template<class T, int chunk>
+template<class Iterable>
+ChunkedQueue<T,chunk>::ChunkedQueue(const Iterable& i) {
+  for (const T& v : i)
+    enqueue(v);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Queries
+
+template<class T, int chunk>
+bool ChunkedQueue<T,chunk>::empty() const {
+  return used == 0;
+}
+
+
+template<class T, int chunk>
+int ChunkedQueue<T,chunk>::size() const {
+  return used;
+}
+
+
+template<class T, int chunk>
+T& ChunkedQueue<T,chunk>::peek () const {
+  if (this->empty())
+    throw EmptyError("ChunkedQueue::peek");
+
+  return front->value(front->begin);
+}
+
+
+template<class T, int chunk>
+std::string ChunkedQueue<T,chunk>::str() const {
+  std::ostringstream answer;
+  answer << "ChunkedQueue[";
+
+  for (Block* b = front; b != nullptr; b = b->next) {
+    answer << (b == front ? "" : "|") << b->begin << ":";
+    for (int i = b->begin; i < b->end; ++i)
+      answer << (i == b->begin ? "" : "->") << b->value(i);
+  }
+
+  answer << "](used=" << used << ",chunk=" << chunk << ",front=" << front << ",rear=" << rear
+         << ",spares=" << spares << ",mod_count=" << mod_count << ")";
+  return answer.str();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Commands
+
+template<class T, int chunk>
+int ChunkedQueue<T,chunk>::enqueue(const T& element) {
+  if (rear == nullptr)
+    front = rear = new_block();
+  else if (rear->end == chunk)
+    rear = rear->next = new_block();
+
+  new (&rear->value(rear->end)) T(element);
+  ++rear->end;
+  ++used;
+  ++mod_count;
+  return 1;
+}
+
+
+template<class T, int chunk>
+T ChunkedQueue<T,chunk>::dequeue() {
+  if (this->empty())
+    throw EmptyError("ChunkedQueue::dequeue");
+
+  T answer = std::move(front->value(front->begin));
+  front->value(front->begin).~T();
+  if (++front->begin == front->end) {
+    Block* to_recycle = front;
+    front = front->next;
+    if (front == nullptr)
+      rear = nullptr;
+    recycle_block(to_recycle);
+  }
+  --used;
+  ++mod_count;
+  return answer;
+}
+
+
+template<class T, int chunk>
+void ChunkedQueue<T,chunk>::clear() {
+  delete_list();
+  used = 0;
+  ++mod_count;
+}
+
+
+template<class T, int chunk>
+template<class Iterable>
+int ChunkedQueue<T,chunk>::enqueue_all(const Iterable& i) {
+  int count = 0;
+  for (const T& v : i)
+     count += enqueue(v);
+
+    return count;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Operators
+
+template<class T, int chunk>
+ChunkedQueue<T,chunk>& ChunkedQueue<T,chunk>::operator = (const ChunkedQueue<T,chunk>& rhs) {
+  if (this == &rhs)
+    return *this;
+
+  //Emptied Blocks go on spare, where enqueue reuses them
+  delete_list();
+  used = 0;
+  for (Block* b = rhs.front; b != nullptr; b = b->next)
+    for (int i = b->begin; i < b->end; ++i)
+      enqueue(b->value(i));
+
+  ++mod_count;
+  return *this;
+}
+
+
+template<class T, int chunk>
+bool ChunkedQueue<T,chunk>::operator == (const ChunkedQueue<T,chunk>& rhs) const {
+  if (this == &rhs)
+    return true;
+  if (used != rhs.size())
+    return false;
+  ChunkedQueue<T,chunk>::FastIterator rhs_i = rhs.fast_begin();
+  for (Block* b = front; b != nullptr; b = b->next)
+    for (int i = b->begin; i < b->end; ++i, ++rhs_i)
+      if (b->value(i) != *rhs_i)
+        return false;
+
+  return true;
+}
+
+
+template<class T, int chunk>
+bool ChunkedQueue<T,chunk>::operator != (const ChunkedQueue<T,chunk>& rhs) const {
+  return !(*this == rhs);
+}
+
+
+template<class T, int chunk>
+std::ostream& operator << (std::ostream& outs, const ChunkedQueue<T,chunk>& q) {
+  outs << "queue[";
+
+  bool first = true;
+  for (typename ChunkedQueue<T,chunk>::Block* b = q.front; b != nullptr; b = b->next)
+    for (int i = b->begin; i < b->end; ++i, first = false)
+      outs << (first ? "" : ",") << b->value(i);
+
+  outs << "]:rear";
+  return outs;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Iterator constructors
+
+template<class T, int chunk>
+auto ChunkedQueue<T,chunk>::begin () const -> ChunkedQueue<T,chunk>::Iterator {
+  return Iterator(const_cast<ChunkedQueue<T,chunk>*>(this),front);
+}
+
+template<class T, int chunk>
+auto ChunkedQueue<T,chunk>::end () const -> ChunkedQueue<T,chunk>::Iterator {
+  return Iterator(const_cast<ChunkedQueue<T,chunk>*>(this),nullptr);
+}
+
+
+template<class T, int chunk>
+auto ChunkedQueue<T,chunk>::fast_begin () const -> ChunkedQueue<T,chunk>::FastIterator {
+  return FastIterator(front);
+}
+
+
+template<class T, int chunk>
+auto ChunkedQueue<T,chunk>::fast_end () const -> ChunkedQueue<T,chunk>::FastIterator {
+  return FastIterator(nullptr);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Private helper methods
+
+template<class T, int chunk>
+auto ChunkedQueue<T,chunk>::new_block() -> Block* {
+  Block* answer;
+  if (spare != nullptr) {
+    answer = spare;
+    spare  = spare->next;
+    --spares;
+  }else
+    answer = new Block;
+
+  answer->next  = nullptr;
+  answer->begin = answer->end = 0;
+  return answer;
+}
+
+
+template<class T, int chunk>
+void ChunkedQueue<T,chunk>::recycle_block(Block* b) {
+  if (spares == max_spare) {
+    delete b;
+    return;
+  }
+  b->next = spare;
+  spare   = b;
+  ++spares;
+}
+
+
+template<class T, int chunk>
+void ChunkedQueue<T,chunk>::delete_list() {
+  for (Block* b = front; b != nullptr; /*see body*/) {
+    Block* to_recycle = b;
+    b = b->next;
+    for (int i = to_recycle->begin; i < to_recycle->end; ++i)
+      to_recycle->value(i).~T();
+    recycle_block(to_recycle);
+  }
+
+  front = rear = nullptr;
+}
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Iterator class definitions
+
+template<class T, int chunk>
+ChunkedQueue<T,chunk>::Iterator::Iterator(ChunkedQueue<T,chunk>* iterate_over, Block* initial)
+: current(initial), index(initial == nullptr ? 0 : initial->begin), ref_queue(iterate_over), expected_mod_count(ref_queue->mod_count) {
+}
+
+
+template<class T, int chunk>
+ChunkedQueue<T,chunk>::Iterator::~Iterator()
+{}
+
+
+template<class T, int chunk>
+void ChunkedQueue<T,chunk>::Iterator::advance() {
+  if (++index < current->end)
+    return;
+  prev    = current;
+  current = current->next;
+  index   = (current == nullptr ? 0 : current->begin);
+}
+
+
+template<class T, int chunk>
+T ChunkedQueue<T,chunk>::Iterator::erase() {
+  if (expected_mod_count != ref_queue->mod_count)
+    throw ConcurrentModificationError("ChunkedQueue::Iterator::erase");
+  if (!can_erase)
+    throw CannotEraseError("ChunkedQueue::Iterator::erase Iterator cursor already erased");
+  if (current == nullptr)
+    throw CannotEraseError("ChunkedQueue::Iterator::erase Iterator cursor beyond data structure");
+
+  can_erase = false;
+  T to_return = std::move(current->value(index));
+
+  //Shift the later values in this Block down by one; the next value is then at index
+  for (int i = index+1; i < current->end; ++i)
+    current->value(i-1) = std::move(current->value(i));
+  current->value(--current->end).~T();
+
+  if (current->begin == current->end) {  //Unlink the emptied Block
+    Block* to_recycle = current;
+    current = current->next;
+    if (prev == nullptr)
+      ref_queue->front = current;
+    else
+      prev->next = current;
+    if (to_recycle == ref_queue->rear)
+      ref_queue->rear = prev;
+    ref_queue->recycle_block(to_recycle);
+    index = (current == nullptr ? 0 : current->begin);
+  }else if (index == current->end) {     //Erased the last value in this Block
+    prev    = current;
+    current = current->next;
+    index   = (current == nullptr ? 0 : current->begin);
+  }
+
+  --ref_queue->used;
+  expected_mod_count = ++ref_queue->mod_count;
+  return to_return;
+}
+
+
+template<class T, int chunk>
+std::string ChunkedQueue<T,chunk>::Iterator::str() const {
+  std::ostringstream answer;
+  answer << ref_queue->str() << "(current=" << current << ",index=" << index << ",expected_mod_count=" << expected_mod_count << ",can_erase=" << can_erase << ")";
+  return answer.str();
+}
+
+
+template<class T, int chunk>
+auto ChunkedQueue<T,chunk>::Iterator::operator ++ () -> ChunkedQueue<T,chunk>::Iterator& {
+  if (expected_mod_count != ref_queue->mod_count)
+    throw ConcurrentModificationError("ChunkedQueue::Iterator::operator ++");
+
+  if (current == nullptr)
+    return *this;
+
+  if (can_erase)
+    advance();
+  else
+    can_erase = true;
+
+  return *this;
+}
+
+
+template<class T, int chunk>
+auto ChunkedQueue<T,chunk>::Iterator::operator ++ (int) -> ChunkedQueue<T,chunk>::Iterator {
+  if (expected_mod_count != ref_queue->mod_count)
+    throw ConcurrentModificationError("ChunkedQueue::Iterator::operator ++(int)");
+
+  if (current == nullptr)
+    return *this;
+
+  Iterator to_return(*this);
+
+  if (can_erase)
+    advance();
+  else
+    can_erase = true;
+
+  return to_return;
+}
+
+
+template<class T, int chunk>
+bool ChunkedQueue<T,chunk>::Iterator::operator == (const ChunkedQueue<T,chunk>::Iterator& rhs) const {
+  const Iterator* rhsASI = dynamic_cast<const Iterator*>(&rhs);
+  if (rhsASI == 0)
+    throw IteratorTypeError("ChunkedQueue::Iterator::operator ==");
+  if (expected_mod_count != ref_queue->mod_count)
+    throw ConcurrentModificationError("ChunkedQueue::Iterator::operator ==");
+  if (ref_queue != rhsASI->ref_queue)
+    throw ComparingDifferentIteratorsError("ChunkedQueue::Iterator::operator ==");
+
+  return current == rhsASI->current && index == rhsASI->index;
+}
+
+
+template<class T, int chunk>
+bool ChunkedQueue<T,chunk>::Iterator::operator != (const ChunkedQueue<T,chunk>::Iterator& rhs) const {
+  const Iterator* rhsASI = dynamic_cast<const Iterator*>(&rhs);
+  if (rhsASI == 0)
+    throw IteratorTypeError("ChunkedQueue::Iterator::operator !=");
+  if (expected_mod_count != ref_queue->mod_count)
+    throw ConcurrentModificationError("ChunkedQueue::Iterator::operator !=");
+  if (ref_queue != rhsASI->ref_queue)
+    throw ComparingDifferentIteratorsError("ChunkedQueue::Iterator::operator !=");
+
+  return current != rhsASI->current || index != rhsASI->index;
+}
+
+
+template<class T, int chunk>
+T& ChunkedQueue<T,chunk>::Iterator::operator *() const {
+  if (expected_mod_count != ref_queue->mod_count)
+    throw ConcurrentModificationError("ChunkedQueue::Iterator::operator *");
+  if (!can_erase || current == nullptr) {
+    std::ostringstream where;
+    where << current << "[" << index << "]"
+          << " when front = " << ref_queue->front
+          << " and rear = "   << ref_queue->rear;
+    throw IteratorPositionIllegal("ChunkedQueue::Iterator::operator * Iterator illegal: "+where.str());
+  }
+
+  return current->value(index);
+}
+
+
+template<class T, int chunk>
+T* ChunkedQueue<T,chunk>::Iterator::operator ->() const {
+  if (expected_mod_count != ref_queue->mod_count)
+    throw ConcurrentModificationError("ChunkedQueue::Iterator::operator *");
+  if (!can_erase || current == nullptr) {
+    std::ostringstream where;
+    where << current << "[" << index << "]"
+          << " when front = " << ref_queue->front
+          << " and rear = "   << ref_queue->rear;
+    throw IteratorPositionIllegal("ChunkedQueue::Iterator::operator * Iterator illegal: "+where.str());
+  }
+
+  return &(current->value(index));
+}
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//FastIterator class definitions
+
+template<class T, int chunk>
+ChunkedQueue<T,chunk>::FastIterator::FastIterator(Block* initial)
+: current(initial), index(initial == nullptr ? 0 : initial->begin) {
+}
+
+
+template<class T, int chunk>
+auto ChunkedQueue<T,chunk>::FastIterator::operator ++ () -> ChunkedQueue<T,chunk>::FastIterator& {
+  if (++index == current->end) {
+    current = current->next;
+    index   = (current == nullptr ? 0 : current->begin);
+  }
+  return *this;
+}
+
+
+template<class T, int chunk>
+bool ChunkedQueue<T,chunk>::FastIterator::operator == (const ChunkedQueue<T,chunk>::FastIterator& rhs) const {
+  return current == rhs.current && index == rhs.index;
+}
+
+
+template<class T, int chunk>
+bool ChunkedQueue<T,chunk>::FastIterator::operator != (const ChunkedQueue<T,chunk>::FastIterator& rhs) const {
+  return current != rhs.current || index != rhs.index;
+}
+
+
+template<class T, int chunk>
+T& ChunkedQueue<T,chunk>::FastIterator::operator *() const {
+  return current->value(index);
+}
+
+
+template<class T, int chunk>
+T* ChunkedQueue<T,chunk>::FastIterator::operator ->() const {
+  return &(current->value(index));
+}
+
+
+}
+
+#endif /* CHUNKED_QUEUE_HPP_ */
@@ -0,0 +1,370 @@
+#ifndef CONCURRENT_LINKED_QUEUE_HPP_
+#define CONCURRENT_LINKED_QUEUE_HPP_
+
+#include <string>
+#include <iostream>
+#include <sstream>
+#include <atomic>
+#include <utility>              //For std::move
+#include "ics_exceptions.hpp"
+
+
+namespace ics {
+
+
+//A lock-free, unbounded queue for many concurrent producers and consumers (the Michael-Scott
+//  queue): a linked list of LNs whose first LN is a dummy. enqueue CASes a new LN onto the rear
+//  LN's next (then swings rear); dequeue CASes front forward one LN, and the LN after the old
+//  front (holding the dequeued value) becomes the new dummy. A thread that finds rear lagging
+//  (rear->next != nullptr) swings it forward before retrying, so no thread waits for another.
+//Dequeued LNs are freed safely with hazard pointers: before following a pointer to an LN, a
+//  thread publishes it in a HazardRecord (one per thread in an operation, reused afterward), and
+//  an LN is deleted only when no HazardRecord holds it. Each record keeps the LNs its users
+//  dequeued (retired), scanning all records to free them once it holds retire_scan of them.
+//All methods but str/operator << (only when no other thread is using the queue) may be called
+//  concurrently; size/empty are approximate while other threads are enqueueing/dequeueing.
+template<class T> class ConcurrentLinkedQueue {
+  public:
+    //Destructor/Constructors
+    ~ConcurrentLinkedQueue();
+
+    ConcurrentLinkedQueue          ();
+    ConcurrentLinkedQueue          (const ConcurrentLinkedQueue<T>& to_copy) = delete;
+
+
+    //Queries
+    bool empty      () const;   //Approximate while other threads are enqueueing/dequeueing
+    int  size       () const;   //Approximate while other threads are enqueueing/dequeueing
+    std::string str () const;   //supplies useful debugging information; only when no other thread is using the queue
+
+
+    //Commands
+    int  enqueue     (const T& element);
+    int  enqueue     (T&& element);
+    T    dequeue     ();               //throws EmptyError if empty
+    bool try_dequeue (T& answer);      //false (and answer unchanged) if empty
+    void clear       ();
+
+    //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
+    template <class Iterable>
+    int enqueue_all (const Iterable& i);
+
+
+    //Operators
+    ConcurrentLinkedQueue<T>& operator = (const ConcurrentLinkedQueue<T>& rhs) = delete;
+
+    template<class T2>
+    friend std::ostream& operator << (std::ostream& outs, const ConcurrentLinkedQueue<T2>& q);
+
+
+  private:
+    static const int cache_line  = 64;
+    static const int retire_scan = 64;  //Scan when a record holds this many retired LNs (and 2 per record)
+
+    class LN {
+      public:
+        LN ()                      {}
+        LN (const T& v)            : value(v){}
+        LN (T&& v)                 : value(std::move(v)){}
+
+        T                value;
+        std::atomic<LN*> next {nullptr};
+        LN*              retired_next = nullptr;   //Links a HazardRecord's retired LNs
+    };
+
+    class HazardRecord {                           //Written by one thread at a time
+      public:
+        std::atomic<LN*>   hazard[2];              //LNs its current user may follow (or nullptr)
+        std::atomic<bool>  active {true};          //Some thread is using this record
+        HazardRecord*      next    = nullptr;      //Fixed once the record is on the records list
+        LN*                retired = nullptr;      //Dequeued LNs not yet deleted
+        int                retired_count = 0;
+        char               padding[cache_line];    //So two records (allocated by new) never share a cache line
+
+        HazardRecord() {hazard[0] = nullptr; hazard[1] = nullptr;}
+    };
+
+    alignas(cache_line) std::atomic<LN*> front;    //The dummy LN (its value has been dequeued)
+    alignas(cache_line) std::atomic<LN*> rear;     //The last LN, or (briefly) the one before it
+    alignas(cache_line) std::atomic<int> used;     //Approximate # values
+    std::atomic<HazardRecord*>  records {nullptr}; //Push-only list of all HazardRecords
+    std::atomic<int>            record_count {0};
+
+
+    //Helper methods
+    int           link_rear      (LN* n);                  //Append n; returns 1
+    HazardRecord* acquire_record ();                       //An inactive record (or a new one), now active
+    void          release_record (HazardRecord* r);
+    LN*           protect        (HazardRecord* r, int i, const std::atomic<LN*>& from); //Read from, held in r->hazard[i]
+    void          retire         (HazardRecord* r, LN* n);
+    void          scan           (HazardRecord* r);        //Delete r's retired LNs that no record holds
+};
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//ConcurrentLinkedQueue class and related definitions
+
+//Destructor/Constructors
+
+template<class T>
+ConcurrentLinkedQueue<T>::~ConcurrentLinkedQueue() {
+  for (LN* p = front.load(); p != nullptr; /*see body*/) {
+    LN* to_delete = p;
+    p = p->next.load();
+    delete to_delete;
+  }
+  for (HazardRecord* r = records.load(); r != nullptr; /*see body*/) {
+    for (LN* p = r->retired; p != nullptr; /*see body*/) {
+      LN* to_delete = p;
+      p = p->retired_next;
+      delete to_delete;
+    }
+    HazardRecord* to_delete = r;
+    r = r->next;
+    delete to_delete;
+  }
+}
+
+
+template<class T>
+ConcurrentLinkedQueue<T>::ConcurrentLinkedQueue()
+: used(0) {
+  LN* dummy = new LN();
+  front.store(dummy);
+  rear.store(dummy);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Queries
+
+template<class T>
+bool ConcurrentLinkedQueue<T>::empty() const {
+  return used.load() <= 0;
+}
+
+
+template<class T>
+int ConcurrentLinkedQueue<T>::size() const {
+  int answer = used.load();
+  return answer < 0 ? 0 : answer;
+}
+
+
+template<class T>
+std::string ConcurrentLinkedQueue<T>::str() const {
+  std::ostringstream answer;
+  answer << "ConcurrentLinkedQueue[";
+
+  LN* dummy = front.load();
+  for (LN* p = dummy->next.load(); p != nullptr; p = p->next.load())
+    answer << (p == dummy->next.load() ? "" : "->") << p->value;
+
+  int retired = 0;
+  for (HazardRecord* r = records.load(); r != nullptr; r = r->next)
+    retired += r->retired_count;
+  answer << "](used=" << used.load() << ",front=" << dummy << ",rear=" << rear.load()
+         << ",records=" << record_count.load() << ",retired=" << retired << ")";
+  return answer.str();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Commands
+
+template<class T>
+int ConcurrentLinkedQueue<T>::enqueue(const T& element) {
+  return link_rear(new LN(element));
+}
+
+
+template<class T>
+int ConcurrentLinkedQueue<T>::enqueue(T&& element) {
+  return link_rear(new LN(std::move(element)));
+}
+
+
+template<class T>
+T ConcurrentLinkedQueue<T>::dequeue() {
+  T answer;
+  if (!try_dequeue(answer))
+    throw EmptyError("ConcurrentLinkedQueue::dequeue");
+  return answer;
+}
+
+
+//Once the CAS moves front to next, only this thread reads next->value (next is now the dummy),
+//  so it can be moved out; hazard[1] keeps next from being deleted meanwhile
+template<class T>
+bool ConcurrentLinkedQueue<T>::try_dequeue(T& answer) {
+  HazardRecord* r = acquire_record();
+  for (;;) {
+    LN* f    = protect(r,0,front);
+    LN* next = protect(r,1,f->next);
+    if (front.load() != f)
+      continue;
+    if (next == nullptr) {
+      release_record(r);
+      return false;
+    }
+
+    LN* rr = rear.load();
+    if (f == rr) {                            //rear lags: help swing it forward
+      rear.compare_exchange_strong(rr,next);
+      continue;
+    }
+    if (front.compare_exchange_strong(f,next)) {
+      answer = std::move(next->value);
+      r->hazard[0].store(nullptr);
+      r->hazard[1].store(nullptr);
+      retire(r,f);
+      release_record(r);
+      --used;
+      return true;
+    }
+  }
+}
+
+
+template<class T>
+void ConcurrentLinkedQueue<T>::clear() {
+  T ignore;
+  while (try_dequeue(ignore))
+    ;
+}
+
+
+template<class T>
+template<class Iterable>
+int ConcurrentLinkedQueue<T>::enqueue_all(const Iterable& i) {
+  int count = 0;
+  for (const T& v : i)
+     count += enqueue(v);
+
+  return count;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Operators
+
+template<class T>
+std::ostream& operator << (std::ostream& outs, const ConcurrentLinkedQueue<T>& q) {
+  outs << "queue[";
+
+  typename ConcurrentLinkedQueue<T>::LN* first = q.front.load()->next.load();
+  for (typename ConcurrentLinkedQueue<T>::LN* p = first; p != nullptr; p = p->next.load())
+    outs << (p == first ? "" : ",") << p->value;
+
+  outs << "]:rear";
+  return outs;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Private helper methods
+
+template<class T>
+int ConcurrentLinkedQueue<T>::link_rear(LN* n) {
+  HazardRecord* r = acquire_record();
+  for (;;) {
+    LN* rr   = protect(r,0,rear);
+    LN* next = rr->next.load();
+    if (rear.load() != rr)
+      continue;
+    if (next != nullptr) {                    //rear lags: help swing it forward
+      rear.compare_exchange_strong(rr,next);
+      continue;
+    }
+    if (rr->next.compare_exchange_strong(next,n)) {
+      rear.compare_exchange_strong(rr,n);     //If this fails, another thread already swung it
+      break;
+    }
+  }
+  release_record(r);
+  ++used;
+  return 1;
+}
+
+
+template<class T>
+auto ConcurrentLinkedQueue<T>::acquire_record() -> HazardRecord* {
+  for (HazardRecord* r = records.load(); r != nullptr; r = r->next)
+    if (!r->active.load(std::memory_order_relaxed) && !r->active.exchange(true))
+      return r;
+
+  HazardRecord* r = new HazardRecord();      //active is true
+  r->next = records.load();
+  while (!records.compare_exchange_weak(r->next,r))
+    ;
+  ++record_count;
+  return r;
+}
+
+
+template<class T>
+void ConcurrentLinkedQueue<T>::release_record(HazardRecord* r) {
+  r->hazard[0].store(nullptr);
+  r->hazard[1].store(nullptr);
+  r->active.store(false);
+}
+
+
+//Publish the LN read from from, then reread to confirm it was still there after publishing:
+//  so it was not yet dequeued (or retired) when the hazard became visible to scan
+template<class T>
+auto ConcurrentLinkedQueue<T>::protect(HazardRecord* r, int i, const std::atomic<LN*>& from) -> LN* {
+  LN* answer = from.load();
+  for (;;) {
+    r->hazard[i].store(answer);
+    LN* again = from.load();
+    if (again == answer)
+      return answer;
+    answer = again;
+  }
+}
+
+
+template<class T>
+void ConcurrentLinkedQueue<T>::retire(HazardRecord* r, LN* n) {
+  n->retired_next = r->retired;
+  r->retired      = n;
+  if (++r->retired_count >= retire_scan + 2*record_count.load())
+    scan(r);
+}
+
+
+template<class T>
+void ConcurrentLinkedQueue<T>::scan(HazardRecord* r) {
+  LN* keep       = nullptr;
+  int keep_count = 0;
+  for (LN* p = r->retired; p != nullptr; /*see body*/) {
+    LN* n = p;
+    p = p->retired_next;
+
+    bool held = false;
+    for (HazardRecord* h = records.load(); h != nullptr && !held; h = h->next)
+      held = h->hazard[0].load() == n || h->hazard[1].load() == n;
+
+    if (held) {
+      n->retired_next = keep;
+      keep = n;
+      ++keep_count;
+    }else
+      delete n;
+  }
+  r->retired       = keep;
+  r->retired_count = keep_count;
+}
+
+}
+
+#endif /* CONCURRENT_LINKED_QUEUE_HPP_ */
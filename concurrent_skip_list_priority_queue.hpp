@@ -0,0 +1,462 @@
+#ifndef CONCURRENT_SKIP_LIST_PRIORITY_QUEUE_HPP_
+#define CONCURRENT_SKIP_LIST_PRIORITY_QUEUE_HPP_
+
+#include <string>
+#include <iostream>
+#include <sstream>
+#include <atomic>
+#include <cstdint>
+#include "ics_exceptions.hpp"
+
+
+namespace ics {
+
+
+#ifndef undefinedgtdefined
+#define undefinedgtdefined
+template<class T>
+bool undefinedgt (const T& a, const T& b) {return false;}
+#endif /* undefinedgtdefined */
+
+//A lock-free skip-list priority queue for many concurrent producers and consumers (the
+//  Linden-Jonsson design). enqueue links a node in with CAS, bottom level first. dequeue claims
+//  the first unclaimed node with one fetch_or that sets a delete mark in the low bit of its
+//  predecessor's level 0 next pointer, so claimed nodes always form a prefix of the list; only
+//  when that prefix is longer than bound_offset does a dequeue swing the header past it (one CAS)
+//  and repair the higher levels. Values of equal priority are dequeued in FIFO order.
+//Nodes removed from the list are freed by epoch-based reclamation: each enqueue/dequeue runs in
+//  an EpochRecord (one per thread in an operation, reused afterward) that records the global
+//  epoch when it began. The epoch advances only when every active record has seen it, so a node
+//  retired in epoch e is unreachable by every operation once the epoch reaches e+2; each record
+//  keeps the nodes its users retired and frees those that old once it holds retire_scan of them.
+//  collect() frees all retired nodes at once (call it only when no other thread is using the queue).
+//
+//Instantiate the templated class supplying tgt(a,b): true, iff a has higher priority than b.
+//If tgt is defaulted to undefinedgt in the template, then a constructor must supply cgt.
+//If both tgt and cgt are supplied, then they must be the same (by ==) function.
+//If neither is supplied, or both are supplied but different, TemplateFunctionError is raised.
+template<class T, bool (*tgt)(const T& a, const T& b) = undefinedgt<T>> class ConcurrentSkipListPriorityQueue {
+  public:
+    typedef bool (*gtfunc) (const T& a, const T& b);
+
+    //Destructor/Constructors
+    ~ConcurrentSkipListPriorityQueue();
+
+    explicit ConcurrentSkipListPriorityQueue(bool (*cgt)(const T& a, const T& b) = undefinedgt<T>, int bound_offset = 32);
+    ConcurrentSkipListPriorityQueue(const ConcurrentSkipListPriorityQueue<T,tgt>& to_copy) = delete;
+
+
+    //Queries
+    bool empty      () const;   //Approximate while other threads are enqueueing/dequeueing
+    int  size       () const;   //Approximate while other threads are enqueueing/dequeueing
+    std::string str () const;   //supplies useful debugging information; only when no other thread is using the queue
+
+
+    //Commands
+    int  enqueue     (const T& element);
+    T    dequeue     ();               //throws EmptyError if there is no value to dequeue
+    bool try_dequeue (T& answer);      //false (and answer unchanged) if there is no value to dequeue
+    int  collect     ();               //Free all retired nodes; returns #; only when no other thread is using the queue
+
+    //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
+    template <class Iterable>
+    int enqueue_all (const Iterable& i);
+
+
+    //Operators
+    ConcurrentSkipListPriorityQueue<T,tgt>& operator = (const ConcurrentSkipListPriorityQueue<T,tgt>& rhs) = delete;
+
+
+  private:
+    static const int max_level   = 24;
+    static const int cache_line  = 64;
+    static const int retire_scan = 64;   //Try to free a record's retired nodes when it holds this many
+    typedef std::uintptr_t link;         //SN* with the delete mark in bit 0 (level 0 only)
+
+    class SN {
+      public:
+        SN (int height)             : height(height), next(new std::atomic<link>[height]) {for (int i=0; i<height; ++i) next[i].store(0);}
+        SN (const T& v, int height) : value(v), height(height), next(new std::atomic<link>[height]) {for (int i=0; i<height; ++i) next[i].store(0);}
+        ~SN ()                      {delete[] next;}
+
+        T                  value;
+        int                height;
+        std::atomic<link>* next;           //next[0] marked: the node it points to has been dequeued
+        std::atomic<bool>  inserting {true};  //Its higher levels are still being linked
+        SN*                retired_next  = nullptr;   //Links an EpochRecord's retired nodes
+        unsigned           retired_epoch = 0;         //Global epoch when it was retired
+    };
+
+    class EpochRecord {                               //Written by one thread at a time
+      public:
+        std::atomic<unsigned> epoch {0};              //Global epoch when its user's operation began
+        std::atomic<bool>     active {true};          //Some thread is using this record
+        EpochRecord*          next    = nullptr;      //Fixed once the record is on the records list
+        SN*                   retired = nullptr;      //Retired nodes not yet deleted, newest first
+        int                   retired_count = 0;
+        int                   scan_at = retire_scan;  //Next retired_count at which to reclaim
+        char                  padding[cache_line];    //So two records (allocated by new) never share a cache line
+    };
+
+    gtfunc           gt;                 // The gt used by enqueue (from template or constructor)
+    int              bound_offset;       // Length of claimed prefix tolerated before unlinking it
+    SN*              front;              // Header node: linked into every level
+    std::atomic<int> used {0};
+    std::atomic<unsigned>     epoch {0};          // Global epoch (see class comment)
+    std::atomic<EpochRecord*> records {nullptr};  // Push-only list of all EpochRecords
+
+
+    //Helper methods
+    static bool marked   (link l) {return (l & 1) != 0;}
+    static SN*  pointer  (link l) {return reinterpret_cast<SN*>(l & ~link(1));}
+    static link to_link  (SN* n, bool mark = false) {return reinterpret_cast<link>(n) | link(mark);}
+    static bool claimed  (SN* n)  {return n != nullptr && marked(n->next[0].load());}  //n's successor is claimed, so n is too
+    static int  random_height ();
+    SN*  locate_preds    (const T& element, SN** preds, SN** succs);  //returns last claimed node passed at level 0
+    void restructure     ();             //Move the header's higher-level links past claimed nodes
+    EpochRecord* acquire_record ();      //An inactive record (or a new one), now active in the current epoch
+    void release_record  (EpochRecord* r);
+    void retire          (EpochRecord* r, SN* n);
+    void reclaim         (EpochRecord* r);  //Advance the epoch if possible; delete r's nodes retired 2 epochs ago
+};
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//ConcurrentSkipListPriorityQueue class and related definitions
+
+//Destructor/Constructors
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+ConcurrentSkipListPriorityQueue<T,tgt>::~ConcurrentSkipListPriorityQueue() {
+  collect();
+  for (SN* p = front; p != nullptr; /*see body*/) {
+    SN* to_delete = p;
+    p = pointer(p->next[0].load());
+    delete to_delete;
+  }
+  for (EpochRecord* r = records.load(); r != nullptr; /*see body*/) {
+    EpochRecord* to_delete = r;
+    r = r->next;
+    delete to_delete;
+  }
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+ConcurrentSkipListPriorityQueue<T,tgt>::ConcurrentSkipListPriorityQueue(bool (*cgt)(const T& a, const T& b), int bound_offset)
+: gt(tgt != (gtfunc)undefinedgt<T> ? tgt : cgt), bound_offset(bound_offset < 1 ? 1 : bound_offset) {
+  if (gt == (gtfunc)undefinedgt<T>)
+    throw TemplateFunctionError("ConcurrentSkipListPriorityQueue::constructor: neither specified");
+  if (tgt != (gtfunc)undefinedgt<T> && cgt != (gtfunc)undefinedgt<T> && tgt != cgt)
+    throw TemplateFunctionError("ConcurrentSkipListPriorityQueue::constructor: both specified and different");
+
+  front = new SN(max_level);
+  front->inserting.store(false);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Queries
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+bool ConcurrentSkipListPriorityQueue<T,tgt>::empty() const {
+  return used.load() <= 0;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+int ConcurrentSkipListPriorityQueue<T,tgt>::size() const {
+  int answer = used.load();
+  return answer < 0 ? 0 : answer;
+}
+
+
+//Level 0 in order: claimed values in [], each value followed by its height
+template<class T, bool (*tgt)(const T& a, const T& b)>
+std::string ConcurrentSkipListPriorityQueue<T,tgt>::str() const {
+  std::ostringstream answer;
+  answer << "ConcurrentSkipListPriorityQueue[HEADER";
+
+  for (link l = front->next[0].load(); pointer(l) != nullptr; l = pointer(l)->next[0].load())
+    if (marked(l))
+      answer << "->[" << pointer(l)->value << "](" << pointer(l)->height << ")";
+    else
+      answer << "->" << pointer(l)->value << "(" << pointer(l)->height << ")";
+
+  answer << "](used=" << used.load() << ",bound_offset=" << bound_offset << ")";
+  return answer.str();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Commands
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+int ConcurrentSkipListPriorityQueue<T,tgt>::enqueue(const T& element) {
+  int height = random_height();
+  SN* n = new SN(element,height);
+  EpochRecord* r = acquire_record();
+  SN* preds[max_level];
+  SN* succs[max_level];
+
+  //Level 0 linearizes the enqueue; the CAS fails if preds[0]'s successor changed or was claimed
+  SN*  del;
+  link expected;
+  do {
+    del = locate_preds(element,preds,succs);
+    n->next[0].store(to_link(succs[0]));
+    expected = to_link(succs[0]);
+  } while (!preds[0]->next[0].compare_exchange_strong(expected,to_link(n)));
+  ++used;
+
+  //Higher levels are only hints for searching: give up if n or its successor is claimed meanwhile
+  for (int i = 1; i < height; /*see body*/) {
+    n->next[i].store(to_link(succs[i]));
+    if (marked(n->next[0].load()) || claimed(succs[i]) || del == succs[i])
+      break;
+    expected = to_link(succs[i]);
+    if (preds[i]->next[i].compare_exchange_strong(expected,to_link(n)))
+      ++i;
+    else {
+      del = locate_preds(element,preds,succs);
+      if (succs[0] != n)
+        break;
+    }
+  }
+
+  n->inserting.store(false);
+  release_record(r);
+  return 1;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+T ConcurrentSkipListPriorityQueue<T,tgt>::dequeue() {
+  T answer;
+  if (!try_dequeue(answer))
+    throw EmptyError("ConcurrentSkipListPriorityQueue::dequeue");
+
+  return answer;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+bool ConcurrentSkipListPriorityQueue<T,tgt>::try_dequeue(T& answer) {
+  EpochRecord* r = acquire_record();
+  SN*  x        = front;
+  SN*  new_head = nullptr;   //First node the header may be moved to: claimed, or still being inserted
+  int  offset   = 0;
+  link obs_head = front->next[0].load();
+  link next;
+
+  //Walk the claimed prefix; fetch_or claims the first unclaimed node (if another thread's
+  //  fetch_or got there first, keep walking)
+  do {
+    next = x->next[0].load();
+    if (pointer(next) == nullptr) {
+      release_record(r);
+      return false;
+    }
+    if (new_head == nullptr && x->inserting.load())
+      new_head = x;
+    if (!marked(next))
+      next = x->next[0].fetch_or(1);
+    ++offset;
+    x = pointer(next);
+  } while (marked(next));
+
+  answer = x->value;
+  --used;
+  if (new_head == nullptr)
+    new_head = x;
+
+  //Unlink the claimed prefix only once it is long: one CAS on the header, then repair higher levels
+  if (offset > bound_offset && front->next[0].load() == obs_head &&
+      front->next[0].compare_exchange_strong(obs_head,to_link(new_head,true))) {
+    restructure();
+    for (SN* p = pointer(obs_head); p != new_head; /*see body*/) {
+      SN* to_retire = p;
+      p = pointer(p->next[0].load());
+      retire(r,to_retire);
+    }
+  }
+  release_record(r);
+  return true;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+int ConcurrentSkipListPriorityQueue<T,tgt>::collect() {
+  int count = 0;
+  for (EpochRecord* r = records.load(); r != nullptr; r = r->next) {
+    for (SN* p = r->retired; p != nullptr; ++count) {
+      SN* to_delete = p;
+      p = p->retired_next;
+      delete to_delete;
+    }
+    r->retired       = nullptr;
+    r->retired_count = 0;
+    r->scan_at       = retire_scan;
+  }
+
+  return count;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+template <class Iterable>
+int ConcurrentSkipListPriorityQueue<T,tgt>::enqueue_all (const Iterable& i) {
+  int count = 0;
+  for (const T& v : i)
+     count += enqueue(v);
+
+  return count;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Private helper methods
+
+//xorshift32 per thread: each further level is used with probability 1/2
+template<class T, bool (*tgt)(const T& a, const T& b)>
+int ConcurrentSkipListPriorityQueue<T,tgt>::random_height() {
+  static thread_local std::uint32_t state = 0;
+  if (state == 0)   //Seed each thread differently (xorshift state must be non-0)
+    state = std::uint32_t(reinterpret_cast<std::uintptr_t>(&state) >> 4) | 1;
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+
+  int height = 1;
+  for (std::uint32_t bits = state; (bits & 1) != 0 && height < max_level; bits >>= 1)
+    ++height;
+  return height;
+}
+
+
+//At each level pass claimed nodes and every value element does not have higher priority than
+//  (so equal values stay FIFO); at level 0 also pass the node a marked link points to, so a new
+//  node is never linked into the claimed prefix
+template<class T, bool (*tgt)(const T& a, const T& b)>
+auto ConcurrentSkipListPriorityQueue<T,tgt>::locate_preds(const T& element, SN** preds, SN** succs) -> SN* {
+  SN* pred = front;
+  SN* del  = nullptr;
+  for (int i = max_level-1; i >= 0; --i) {
+    link l   = pred->next[i].load();
+    bool d   = marked(l);
+    SN*  cur = pointer(l);
+    while (cur != nullptr && (!gt(element,cur->value) || claimed(cur) || (i == 0 && d))) {
+      if (i == 0 && d)
+        del = cur;
+      pred = cur;
+      l    = pred->next[i].load();
+      d    = marked(l);
+      cur  = pointer(l);
+    }
+    preds[i] = pred;
+    succs[i] = cur;
+  }
+
+  return del;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+void ConcurrentSkipListPriorityQueue<T,tgt>::restructure() {
+  SN* pred = front;
+  for (int i = max_level-1; i > 0; /*see body*/) {
+    link h   = front->next[i].load();
+    SN*  cur = pointer(pred->next[i].load());
+    if (!claimed(pointer(h))) {
+      --i;
+      continue;
+    }
+    while (claimed(cur)) {
+      pred = cur;
+      cur  = pointer(pred->next[i].load());
+    }
+    if (front->next[i].compare_exchange_strong(h,pred->next[i].load()))
+      --i;
+  }
+}
+
+
+//Publish the epoch read, then reread to confirm it was still current after publishing: so no
+//  advance past it can have missed this record (the epoch is at most one ahead of it until release)
+template<class T, bool (*tgt)(const T& a, const T& b)>
+auto ConcurrentSkipListPriorityQueue<T,tgt>::acquire_record() -> EpochRecord* {
+  EpochRecord* r = nullptr;
+  for (EpochRecord* f = records.load(); f != nullptr && r == nullptr; f = f->next)
+    if (!f->active.load(std::memory_order_relaxed) && !f->active.exchange(true))
+      r = f;
+
+  if (r == nullptr) {
+    r = new EpochRecord();                   //active is true
+    r->next = records.load();
+    while (!records.compare_exchange_weak(r->next,r))
+      ;
+  }
+
+  unsigned e = epoch.load();
+  for (;;) {
+    r->epoch.store(e);
+    unsigned again = epoch.load();
+    if (again == e)
+      return r;
+    e = again;
+  }
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+void ConcurrentSkipListPriorityQueue<T,tgt>::release_record(EpochRecord* r) {
+  r->active.store(false);
+}
+
+
+//n has been unlinked, so an operation beginning after this epoch.load() cannot reach it
+template<class T, bool (*tgt)(const T& a, const T& b)>
+void ConcurrentSkipListPriorityQueue<T,tgt>::retire(EpochRecord* r, SN* n) {
+  n->retired_epoch = epoch.load();
+  n->retired_next  = r->retired;
+  r->retired       = n;
+  if (++r->retired_count >= r->scan_at)
+    reclaim(r);
+}
+
+
+//A node retired in epoch e may still be read by operations that began in e-1 or e (which an
+//  active record at e-1 or e shows), but by none once the epoch is e+2
+template<class T, bool (*tgt)(const T& a, const T& b)>
+void ConcurrentSkipListPriorityQueue<T,tgt>::reclaim(EpochRecord* r) {
+  unsigned e       = epoch.load();
+  bool     advance = true;
+  for (EpochRecord* h = records.load(); h != nullptr && advance; h = h->next)
+    advance = !h->active.load() || h->epoch.load() == e;
+  if (advance && epoch.compare_exchange_strong(e,e+1))
+    ++e;
+
+  //Retired nodes are newest first, so those old enough form a suffix of the list
+  SN** p = &r->retired;
+  while (*p != nullptr && int(e - (*p)->retired_epoch) < 2)
+    p = &(*p)->retired_next;
+  for (SN* q = *p; q != nullptr; /*see body*/) {
+    SN* to_delete = q;
+    q = q->retired_next;
+    delete to_delete;
+    --r->retired_count;
+  }
+  *p = nullptr;
+  r->scan_at = r->retired_count + retire_scan;   //If a stalled thread holds back the epoch, scan less often
+}
+
+}
+
+#endif /* CONCURRENT_SKIP_LIST_PRIORITY_QUEUE_HPP_ */
@@ -0,0 +1,530 @@
+#ifndef EXTERNAL_PRIORITY_QUEUE_HPP_
+#define EXTERNAL_PRIORITY_QUEUE_HPP_
+
+#include <string>
+#include <iostream>
+#include <sstream>
+#include <cstdio>               //For std::tmpfile/fread/fwrite
+#include <type_traits>          //For std::is_trivially_copyable
+#include <utility>              //For std::swap function
+#include <exception>            //For std::exception_ptr (see merge_smallest)
+#include "ics_exceptions.hpp"
+#include "heap_priority_queue.hpp"
+
+
+namespace ics {
+
+
+//A priority queue that can hold more values than fit in memory. Values are enqueued into an
+//  in-memory HeapPriorityQueue buffer; when it is full, its values are written in priority order
+//  as one sorted "run" to a temp file (std::tmpfile: deleted when closed). dequeue returns the
+//  higher of the buffer's top and the best run head; run heads are kept in a small heap (one entry
+//  per run), and each run is read back one block at a time.
+//At most max_runs runs are open (each holds a file): before spilling another, the max_runs/2 (>= 2) runs
+//  with the fewest values left are merged into one. Small runs are merged often and large ones
+//  rarely, so each value is rewritten about log(N/memory_budget) times.
+//Memory use is bounded by memory_budget values: the blocks (one per open run, plus three for
+//  spilling and merging) take at most half of it, and are io_buffer_values long at most; the
+//  buffer gets the rest. Values are written and read as raw bytes, so T must be trivially copyable.
+//
+//Instantiate the templated class supplying tgt(a,b): true, iff a has higher priority than b.
+//If tgt is defaulted to undefinedgt in the template, then a constructor must supply cgt.
+//If both tgt and cgt are supplied, then they must be the same (by ==) function.
+//If neither is supplied, or both are supplied but different, TemplateFunctionError is raised.
+template<class T, bool (*tgt)(const T& a, const T& b) = undefinedgt<T>> class ExternalPriorityQueue {
+  static_assert(std::is_trivially_copyable<T>::value, "ExternalPriorityQueue: T must be trivially copyable");
+
+  public:
+    typedef bool (*gtfunc) (const T& a, const T& b);
+
+    //Destructor/Constructors
+    ~ExternalPriorityQueue();
+
+    explicit ExternalPriorityQueue(int memory_budget = 1<<20, int io_buffer_values = 1<<12, int max_runs = 64,
+                                   bool (*cgt)(const T& a, const T& b) = undefinedgt<T>);
+    ExternalPriorityQueue(const ExternalPriorityQueue<T,tgt>& to_copy) = delete;
+
+
+    //Queries
+    bool empty      () const;
+    long long size  () const;
+    int  runs       () const;   //# of runs on disk not yet exhausted
+    const T& peek   () const;
+    std::string str () const; //supplies useful debugging information; contrast to operator <<
+
+
+    //Commands
+    int  enqueue (const T& element);   //may write (or merge) runs (throws IcsError if a temp file fails)
+    T    dequeue ();                   //may read a run's next block
+    void clear   ();
+
+    //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
+    template <class Iterable>
+    int enqueue_all (const Iterable& i);
+
+
+    //Operators
+    ExternalPriorityQueue<T,tgt>& operator = (const ExternalPriorityQueue<T,tgt>& rhs) = delete;
+
+    template<class T2, bool (*gt2)(const T2& a, const T2& b)>
+    friend std::ostream& operator << (std::ostream& outs, const ExternalPriorityQueue<T2,gt2>& pq);
+
+
+  private:
+    class Run {
+      public:
+        std::FILE* file    = nullptr;
+        T*         block   = nullptr;  //Values read from file; block[next..in_block) not yet dequeued
+        int        next     = 0;
+        int        in_block = 0;
+        long long  on_disk  = 0;       //# values in file not yet read into block
+        long long  block_at = 0;       //Index in file of block[0] (see merge_smallest)
+
+        long long  left () const {return in_block-next+on_disk;}
+    };
+
+    bool (*gt) (const T& a, const T& b);  // The gt used by enqueue (from template or constructor)
+    int   memory_budget;
+    int   io_buffer_values;
+    int   max_runs;
+    int   block_values;                 // Length of each Run's block, out, and a merge's output block
+    int   buffer_capacity;              // memory_budget less all the blocks
+    HeapPriorityQueue<T,tgt> buffer;    // Values not yet spilled
+    Run*  run;                          // run[0..run_length): a Run with file == nullptr is free
+    int   run_length = 0;
+    int*  heads;                        // Binary heap of indexes into run, ordered by their heads
+    int   heads_used = 0;
+    T*    out;                          // block_values values being written by spill (or read by read_block)
+    long long used = 0;                 // # of values in buffer and runs
+
+
+    //Helper methods
+    void spill          ();                  //Write buffer as one run; buffer becomes empty (unchanged if it throws)
+    void merge_smallest ();                  //Merge the max_runs/2 runs with fewest values left (unchanged if it throws)
+    int  free_run       ();                  //Index of a Run with no file, growing run/heads if needed
+    bool read_block     (Run& r);            //Read r's next block; false if none; r unchanged if it throws
+    bool fill           (Run& r);            //read_block, but close r if exhausted
+    bool rewind_run     (Run& r, const Run& saved);
+    void close          (Run& r);
+    void remove_closed_heads ();
+    const T& head       (int r) const;       //Head value of run[r]
+    void sift_up        (int* hs, int h);         //Restore a heap of run indexes hs[0..h] after placing hs[h]
+    void sift_down      (int* hs, int n, int h);  //Restore heap hs[0..n) after hs[h]'s head fell
+    static int blocks_length (int memory_budget, int io_buffer_values, int max_runs);
+};
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//ExternalPriorityQueue class and related definitions
+
+//Destructor/Constructors
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+ExternalPriorityQueue<T,tgt>::~ExternalPriorityQueue() {
+  for (int r=0; r<run_length; ++r)
+    close(run[r]);
+  delete[] run;
+  delete[] heads;
+  delete[] out;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+ExternalPriorityQueue<T,tgt>::ExternalPriorityQueue(int memory_budget, int io_buffer_values, int max_runs, bool (*cgt)(const T& a, const T& b))
+: gt(tgt != (gtfunc)undefinedgt<T> ? tgt : cgt),
+  memory_budget(memory_budget < 2 ? 2 : memory_budget), io_buffer_values(io_buffer_values < 1 ? 1 : io_buffer_values),
+  max_runs(max_runs < 2 ? 2 : max_runs),
+  block_values(blocks_length(this->memory_budget,this->io_buffer_values,this->max_runs)),
+  buffer_capacity(this->memory_budget - (this->max_runs+3)*block_values < 1 ? 1 : this->memory_budget - (this->max_runs+3)*block_values),
+  buffer(buffer_capacity,gt) {
+  if (gt == (gtfunc)undefinedgt<T>)
+    throw TemplateFunctionError("ExternalPriorityQueue::constructor: neither specified");
+  if (tgt != (gtfunc)undefinedgt<T> && cgt != (gtfunc)undefinedgt<T> && tgt != cgt)
+    throw TemplateFunctionError("ExternalPriorityQueue::constructor: both specified and different");
+
+  run   = new Run[run_length];
+  heads = new int[run_length];
+  out   = new T[block_values];
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Queries
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+bool ExternalPriorityQueue<T,tgt>::empty() const {
+  return used == 0;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+long long ExternalPriorityQueue<T,tgt>::size() const {
+  return used;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+int ExternalPriorityQueue<T,tgt>::runs() const {
+  return heads_used;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+const T& ExternalPriorityQueue<T,tgt>::peek () const {
+  if (empty())
+    throw EmptyError("ExternalPriorityQueue::peek");
+
+  if (heads_used == 0 || (!buffer.empty() && !gt(head(heads[0]),buffer.peek())))
+    return buffer.peek();
+  return head(heads[0]);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+std::string ExternalPriorityQueue<T,tgt>::str() const {
+  std::ostringstream answer;
+  answer << "ExternalPriorityQueue[buffer=" << buffer.str() << ",runs=";
+
+  for (int h=0; h<heads_used; ++h) {
+    const Run& r = run[heads[h]];
+    answer << (h == 0 ? "" : ",") << heads[h] << ":" << r.block[r.next]
+           << "(" << (r.in_block-r.next) << "+" << r.on_disk << ")";
+  }
+
+  answer << "](used=" << used << ",memory_budget=" << memory_budget << ",io_buffer_values=" << io_buffer_values
+         << ",max_runs=" << max_runs << ",block_values=" << block_values << ",buffer_capacity=" << buffer_capacity
+         << ",run_length=" << run_length << ")";
+  return answer.str();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Commands
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+int ExternalPriorityQueue<T,tgt>::enqueue(const T& element) {
+  if (buffer.size() == buffer_capacity)
+    spill();
+
+  buffer.enqueue(element);
+  ++used;
+  return 1;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+T ExternalPriorityQueue<T,tgt>::dequeue() {
+  if (this->empty())
+    throw EmptyError("ExternalPriorityQueue::dequeue");
+
+  if (heads_used == 0 || (!buffer.empty() && !gt(head(heads[0]),buffer.peek()))) {
+    --used;
+    return buffer.dequeue();
+  }
+
+  //If fill throws, r (and its head) are unchanged: the value is not removed
+  Run& r = run[heads[0]];
+  T to_return = r.block[r.next];
+  if (r.next+1 < r.in_block)
+    ++r.next;
+  else if (!fill(r))
+    heads[0] = heads[--heads_used];   //Run exhausted: remove it from the heap of heads
+  if (heads_used != 0)
+    sift_down(heads,heads_used,0);
+  --used;
+  return to_return;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+void ExternalPriorityQueue<T,tgt>::clear() {
+  for (int r=0; r<run_length; ++r)
+    close(run[r]);
+  heads_used = 0;
+  buffer.clear();
+  used = 0;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+template <class Iterable>
+int ExternalPriorityQueue<T,tgt>::enqueue_all (const Iterable& i) {
+  int count = 0;
+  for (const T& v : i)
+    count += enqueue(v);
+
+  return count;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Operators
+
+//Shows only the in-memory buffer (reading the runs back would consume them)
+template<class T, bool (*tgt)(const T& a, const T& b)>
+std::ostream& operator << (std::ostream& outs, const ExternalPriorityQueue<T,tgt>& p) {
+  outs << "external_priority_queue[" << p.buffer << ",runs=" << p.heads_used << "]:size=" << p.used;
+  return outs;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Private helper methods
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+void ExternalPriorityQueue<T,tgt>::spill() {
+  if (heads_used == max_runs)
+    merge_smallest();
+
+  int  r       = free_run();
+  Run& spilled = run[r];
+  spilled.file = std::tmpfile();
+  if (spilled.file == nullptr)
+    throw IcsError("ExternalPriorityQueue::spill: cannot create temp file");
+
+  //Write the buffer's values in priority order without removing them (its Iterator does not copy
+  //  the heap); most write errors show up only when stdio flushes, so flush and check before
+  //  reading back. The buffer is cleared only after the run's first block is read successfully.
+  bool written = true;
+  int  n       = 0;
+  for (auto i = buffer.begin(); written && i != buffer.end(); ++i) {
+    out[n++] = *i;
+    if (n == block_values) {
+      written = std::fwrite(out,sizeof(T),n,spilled.file) == std::size_t(n);
+      n = 0;
+    }
+  }
+  if (written && n != 0)
+    written = std::fwrite(out,sizeof(T),n,spilled.file) == std::size_t(n);
+  if (!written || std::fflush(spilled.file) != 0 || std::ferror(spilled.file)) {
+    close(spilled);
+    throw IcsError("ExternalPriorityQueue::spill: cannot write temp file");
+  }
+
+  std::rewind(spilled.file);
+  spilled.on_disk = buffer.size();
+  spilled.block   = new T[block_values];
+  try {
+    fill(spilled);
+  } catch (...) {
+    close(spilled);
+    throw;
+  }
+  buffer.clear();
+  heads[heads_used] = r;
+  sift_up(heads,heads_used++);
+}
+
+
+//Runs are not changed once written, so if the merge fails each source is put back by re-reading
+//  its block from block_at (see rewind_run): no value is lost and the heap of heads is unchanged.
+//  On success the sources are closed, and the merged run replaces them in heads.
+template<class T, bool (*tgt)(const T& a, const T& b)>
+void ExternalPriorityQueue<T,tgt>::merge_smallest() {
+  //Selection sort the k runs with the fewest values left to heads[0..k); heads is re-heaped below
+  int k = max_runs/2 < 2 ? 2 : max_runs/2;
+  for (int i=0; i<k; ++i) {
+    int fewest = i;
+    for (int j=i+1; j<heads_used; ++j)
+      if (run[heads[j]].left() < run[heads[fewest]].left())
+        fewest = j;
+    std::swap(heads[i],heads[fewest]);
+  }
+
+  Run* saved   = new Run[k];           //Positions of the sources before the merge
+  int* sources = new int[k];           //Heap of the sources not yet exhausted
+  for (int i=0; i<k; ++i) {
+    saved[i]   = run[heads[i]];
+    sources[i] = heads[i];
+    sift_up(sources,i);
+  }
+
+  Run  merged;
+  T*   to_write = new T[block_values];
+  bool written  = (merged.file = std::tmpfile()) != nullptr;
+  std::exception_ptr error;
+  try {
+    int n = 0;
+    for (int in_heap = k; written && in_heap != 0; ) {
+      Run& r = run[sources[0]];
+      to_write[n++] = r.block[r.next];
+      if (r.next+1 < r.in_block)
+        ++r.next;
+      else if (!read_block(r))
+        sources[0] = sources[--in_heap];
+      if (in_heap != 0)
+        sift_down(sources,in_heap,0);
+      if (n == block_values || in_heap == 0) {
+        written = std::fwrite(to_write,sizeof(T),n,merged.file) == std::size_t(n);
+        merged.on_disk += n;
+        n = 0;
+      }
+    }
+    written = written && std::fflush(merged.file) == 0 && !std::ferror(merged.file);
+    if (written) {
+      std::rewind(merged.file);
+      merged.block = new T[block_values];
+      read_block(merged);
+    }
+  } catch (...) {
+    error = std::current_exception();
+  }
+  delete[] to_write;
+  delete[] sources;
+
+  if (!written || error) {
+    close(merged);
+    for (int i=0; i<k; ++i)
+      if (!rewind_run(run[heads[i]],saved[i])) {
+        used -= saved[i].left();
+        close(run[heads[i]]);
+      }
+    delete[] saved;
+    remove_closed_heads();
+    if (error)
+      std::rethrow_exception(error);
+    throw IcsError("ExternalPriorityQueue::merge_smallest: cannot merge runs through a temp file");
+  }
+
+  delete[] saved;
+  int r = heads[0];
+  for (int i=0; i<k; ++i)
+    close(run[heads[i]]);
+  remove_closed_heads();
+  run[r] = merged;
+  heads[heads_used] = r;
+  sift_up(heads,heads_used++);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+int ExternalPriorityQueue<T,tgt>::free_run() {
+  int r = 0;
+  while (r < run_length && run[r].file != nullptr)
+    ++r;
+  if (r == run_length) {
+    int  new_length = run_length == 0 ? 4 : 2*run_length;
+    Run* new_run    = new Run[new_length];
+    int* new_heads  = new int[new_length];
+    for (int i=0; i<run_length; ++i) {
+      new_run[i]   = run[i];
+      new_heads[i] = heads[i];
+    }
+    delete[] run;
+    delete[] heads;
+    run        = new_run;
+    heads      = new_heads;
+    run_length = new_length;
+  }
+  return r;
+}
+
+
+//Blocks are read in file order, so the next block starts right after the current one
+template<class T, bool (*tgt)(const T& a, const T& b)>
+bool ExternalPriorityQueue<T,tgt>::read_block(Run& r) {
+  if (r.on_disk == 0)
+    return false;
+
+  //Read into out, then swap it with r.block: if the read fails, r.block is unchanged
+  int n = r.on_disk < block_values ? int(r.on_disk) : block_values;
+  if (std::fread(out,sizeof(T),n,r.file) != std::size_t(n))
+    throw IcsError("ExternalPriorityQueue::read_block: cannot read temp file");
+  std::swap(r.block,out);
+  r.block_at += r.in_block;
+  r.on_disk  -= n;
+  r.next      = 0;
+  r.in_block  = n;
+  return true;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+bool ExternalPriorityQueue<T,tgt>::fill(Run& r) {
+  if (read_block(r))
+    return true;
+
+  close(r);
+  return false;
+}
+
+
+//Put r back where saved (a copy of r) was; false if its block cannot be read again
+template<class T, bool (*tgt)(const T& a, const T& b)>
+bool ExternalPriorityQueue<T,tgt>::rewind_run(Run& r, const Run& saved) {
+  r.next     = saved.next;
+  r.in_block = saved.in_block;
+  r.on_disk  = saved.on_disk;
+  r.block_at = saved.block_at;
+  return std::fseek(r.file,long(r.block_at*sizeof(T)),SEEK_SET) == 0 &&
+         std::fread(r.block,sizeof(T),r.in_block,r.file) == std::size_t(r.in_block);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+void ExternalPriorityQueue<T,tgt>::close(Run& r) {
+  if (r.file != nullptr)
+    std::fclose(r.file);
+  delete[] r.block;
+  r = Run();
+}
+
+
+//Drop the closed runs from heads, then re-heap it
+template<class T, bool (*tgt)(const T& a, const T& b)>
+void ExternalPriorityQueue<T,tgt>::remove_closed_heads() {
+  int h = 0;
+  for (int i=0; i<heads_used; ++i)
+    if (run[heads[i]].file != nullptr)
+      heads[h++] = heads[i];
+  heads_used = h;
+  for (h=1; h<heads_used; ++h)
+    sift_up(heads,h);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+const T& ExternalPriorityQueue<T,tgt>::head(int r) const {
+  const Run& x = run[r];
+  return x.block[x.next];
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+void ExternalPriorityQueue<T,tgt>::sift_up(int* hs, int h) {
+  for (/*see above*/; h != 0 && gt(head(hs[h]),head(hs[(h-1)/2])); h = (h-1)/2)
+    std::swap(hs[h],hs[(h-1)/2]);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+void ExternalPriorityQueue<T,tgt>::sift_down(int* hs, int n, int h) {
+  for (int l = 2*h+1; l < n; l = 2*h+1) {
+    int max_child = (l+1 >= n || !gt(head(hs[l+1]),head(hs[l])) ? l : l+1);
+    if (!gt(head(hs[max_child]),head(hs[h])))
+      break;
+    std::swap(hs[h],hs[max_child]);
+    h = max_child;
+  }
+}
+
+
+//Half the budget is split into max_runs+3 blocks: one per open run, out, and (while merging)
+//  the merge's output block and the merged run's block
+template<class T, bool (*tgt)(const T& a, const T& b)>
+int ExternalPriorityQueue<T,tgt>::blocks_length(int memory_budget, int io_buffer_values, int max_runs) {
+  int length = memory_budget/2/(max_runs+3);
+  return length < 1 ? 1 : length > io_buffer_values ? io_buffer_values : length;
+}
+
+}
+
+#endif /* EXTERNAL_PRIORITY_QUEUE_HPP_ */
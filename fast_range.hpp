@@ -0,0 +1,36 @@
+#ifndef FAST_RANGE_HPP_
+#define FAST_RANGE_HPP_
+
+
+namespace ics {
+
+
+//Adapts a container to a "for-each" loop: for (auto& v : ics::fast(c)) ...
+//Release builds (NDEBUG) use the unchecked fast_begin/fast_end; debug builds keep the checked begin/end.
+//A FastRange refers to (does not copy) its container, so fast is deleted for temporaries: the
+//  temporary would be destroyed before the loop runs.
+template<class Container>
+class FastRange {
+  private:
+    const Container& c;
+
+  public:
+    FastRange(const Container& c) : c(c) {}
+#ifdef NDEBUG
+    auto begin () const -> decltype(c.fast_begin()) {return c.fast_begin();}
+    auto end   () const -> decltype(c.fast_end())   {return c.fast_end();}
+#else
+    auto begin () const -> decltype(c.begin())      {return c.begin();}
+    auto end   () const -> decltype(c.end())        {return c.end();}
+#endif
+};
+
+template<class Container>
+FastRange<Container> fast(const Container& c) {return FastRange<Container>(c);}
+
+template<class Container>
+void fast(const Container&& c) = delete;
+
+}
+
+#endif /* FAST_RANGE_HPP_ */
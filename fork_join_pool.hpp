@@ -0,0 +1,330 @@
+#ifndef FORK_JOIN_POOL_HPP_
+#define FORK_JOIN_POOL_HPP_
+
+#include <string>
+#include <iostream>
+#include <sstream>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+#include <algorithm>            //For std::max
+#include "ics_exceptions.hpp"
+#include "linked_queue.hpp"
+#include "work_stealing_deque.hpp"
+
+
+namespace ics {
+
+
+//A fork/join thread pool for recursive (divide and conquer) parallelism. Each worker thread owns a
+//  WorkStealingDeque of tasks: a task spawned by a worker goes on the bottom of its own deque (and
+//  it runs its newest task first, depth-first, like sequential recursion), while an idle worker
+//  steals the oldest task (the biggest piece of work) from the top of a random other deque. Tasks
+//  spawned by other threads go on a shared (locked) injected queue. Workers with nothing to run
+//  or steal sleep until a task is spawned.
+//Tasks are spawned into a TaskGroup; sync(group) returns when all its tasks have finished,
+//  running (not just waiting for) queued tasks meanwhile, so nested spawn/sync cannot deadlock.
+//  If a task throws, sync rethrows the first exception (after the group's other tasks finish).
+//Example (the calling thread helps in sync):
+//  ForkJoinPool pool;  ForkJoinPool::TaskGroup g;
+//  pool.spawn(g,[&]{left = f(a);});  right = f(b);  pool.sync(g);
+//HashMap's parallel queries (parallel_reduce, parallel_bins) do not use a ForkJoinPool: they scan
+//  a flat array of bins, with no nested tasks for stealing to balance, and their threads claim
+//  chunks of bins from a shared atomic counter, which already balances the load; so each query
+//  starts its own threads rather than requiring a pool to be built and passed to the map.
+class ForkJoinPool {
+  public:
+    class TaskGroup {
+      public:
+        TaskGroup () : pending(0), failed(false) {}
+        TaskGroup (const TaskGroup& to_copy) = delete;
+
+      private:
+        friend class ForkJoinPool;
+        std::atomic<int>   pending;   //# spawned tasks not yet finished
+        std::atomic<bool>  failed;    //Some task threw; the first exception is in error
+        std::exception_ptr error;
+    };
+
+    //Destructor/Constructors
+    ~ForkJoinPool();   //Call only when no tasks remain (all groups synced)
+
+    explicit ForkJoinPool (int threads = 0);   //threads <= 0 means one per hardware thread
+    ForkJoinPool          (const ForkJoinPool& to_copy) = delete;
+
+
+    //Queries
+    int threads     () const;
+    std::string str () const; //supplies useful debugging information; only when no task is running
+
+
+    //Commands
+    template <class F>
+    void spawn (TaskGroup& g, F f);          //Queue f() to run (on some thread) as part of g
+    void sync  (TaskGroup& g);               //Run tasks until all of g's have finished; rethrow a task's exception
+
+    //Call f(i) for all low <= i < high in parallel: [low,high) is split in halves (spawning one,
+    //  splitting the other) until pieces have at most grain values; f must be safe to call concurrently
+    template <class F>
+    void parallel_for (int low, int high, F f, int grain = 1);
+
+
+    //Operators
+    ForkJoinPool& operator = (const ForkJoinPool& rhs) = delete;
+
+
+  private:
+    class Task {
+      public:
+        Task (const std::function<void()>& f, TaskGroup* group) : f(f), group(group) {}
+
+        std::function<void()> f;
+        TaskGroup*             group;
+    };
+
+    class Worker {                            //Which worker (if any) the calling thread is
+      public:
+        const ForkJoinPool* pool  = nullptr;
+        int                 index = -1;
+    };
+
+    int                         worker_count;
+    std::thread*                workers;
+    WorkStealingDeque<Task*>**  deques;        //deques[i] is owned by workers[i]
+    mutable std::mutex          lock;          //Guards injected (and sleeping workers' waits)
+    std::condition_variable     wake;
+    LinkedQueue<Task*>          injected;      //Tasks spawned by non-worker threads
+    std::atomic<int>            queued;        //# tasks spawned but not yet taken to run
+    std::atomic<int>            sleeping;      //# workers waiting on wake
+    std::atomic<bool>           stopping;
+
+    //Helper methods
+    static Worker& me ();                      //The calling thread's Worker (thread_local)
+    int  my_index   () const;                  //Index of the calling thread in this pool, or -1
+    void push       (Task* t);
+    bool find_task  (int index, Task*& t);     //Pop own deque, else steal, else take injected
+    void run        (Task* t);
+    void run_worker (int index);
+    template <class F>
+    void split      (TaskGroup& g, int low, int high, F& f, int grain);
+};
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//ForkJoinPool class and related definitions
+
+//Destructor/Constructors
+
+inline ForkJoinPool::~ForkJoinPool() {
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    stopping.store(true);
+    wake.notify_all();
+  }
+  for (int w=0; w<worker_count; ++w)
+    workers[w].join();
+  delete[] workers;
+
+  Task* t;
+  for (int w=0; w<worker_count; ++w) {
+    while (deques[w]->pop(t))
+      delete t;
+    delete deques[w];
+  }
+  delete[] deques;
+  while (!injected.empty())
+    delete injected.dequeue();
+}
+
+
+inline ForkJoinPool::ForkJoinPool(int threads)
+: worker_count(threads > 0 ? threads : std::max(1,int(std::thread::hardware_concurrency()))),
+  queued(0), sleeping(0), stopping(false) {
+  deques = new WorkStealingDeque<Task*>*[worker_count];
+  for (int w=0; w<worker_count; ++w)
+    deques[w] = new WorkStealingDeque<Task*>();
+  workers = new std::thread[worker_count];
+  for (int w=0; w<worker_count; ++w)
+    workers[w] = std::thread(&ForkJoinPool::run_worker, this, w);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Queries
+
+inline int ForkJoinPool::threads() const {
+  return worker_count;
+}
+
+
+inline std::string ForkJoinPool::str() const {
+  std::ostringstream answer;
+  answer << "ForkJoinPool[";
+
+  for (int w=0; w<worker_count; ++w)
+    answer << (w == 0 ? "" : ",") << w << ":" << deques[w]->size();
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    answer << "](threads=" << worker_count << ",injected=" << injected.size();
+  }
+  answer << ",queued=" << queued.load() << ",sleeping=" << sleeping.load() << ")";
+  return answer.str();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Commands
+
+template<class F>
+void ForkJoinPool::spawn(TaskGroup& g, F f) {
+  g.pending.fetch_add(1);
+  push(new Task(f,&g));
+}
+
+
+inline void ForkJoinPool::sync(TaskGroup& g) {
+  int index = my_index();
+  while (g.pending.load(std::memory_order_acquire) != 0) {
+    Task* t;
+    if (find_task(index,t))
+      run(t);
+    else
+      std::this_thread::yield();
+  }
+
+  if (g.failed.load()) {
+    std::exception_ptr e = g.error;
+    g.error = nullptr;
+    g.failed.store(false);
+    std::rethrow_exception(e);
+  }
+}
+
+
+template<class F>
+void ForkJoinPool::parallel_for(int low, int high, F f, int grain) {
+  TaskGroup g;
+  try {
+    split(g, low, high, f, grain < 1 ? 1 : grain);
+  } catch (...) {
+    try {sync(g);} catch (...) {}   //Spawned pieces refer to g and f: let them finish first
+    throw;
+  }
+  sync(g);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Private helper methods
+
+inline auto ForkJoinPool::me() -> Worker& {
+  thread_local Worker w;
+  return w;
+}
+
+
+inline int ForkJoinPool::my_index() const {
+  Worker& w = me();
+  return w.pool == this ? w.index : -1;
+}
+
+
+//queued is incremented (seq_cst) before sleeping is read, and a worker increments sleeping before
+//  reading queued: so either the worker sees the task or this sees the sleeper (and notifies)
+inline void ForkJoinPool::push(Task* t) {
+  int index = my_index();
+  if (index != -1)
+    deques[index]->push(t);
+  else {
+    std::lock_guard<std::mutex> guard(lock);
+    injected.enqueue(t);
+  }
+
+  queued.fetch_add(1);
+  if (sleeping.load() != 0) {
+    std::lock_guard<std::mutex> guard(lock);
+    wake.notify_one();
+  }
+}
+
+
+inline bool ForkJoinPool::find_task(int index, Task*& t) {
+  if (index != -1 && deques[index]->pop(t)) {
+    queued.fetch_sub(1);
+    return true;
+  }
+
+  //Steal, starting at a different victim for each thief
+  int start = (index == -1 ? 0 : index+1);
+  for (int i=0; i<worker_count; ++i) {
+    int victim = (start+i) % worker_count;
+    if (victim != index && deques[victim]->steal(t)) {
+      queued.fetch_sub(1);
+      return true;
+    }
+  }
+
+  std::lock_guard<std::mutex> guard(lock);
+  if (injected.empty())
+    return false;
+  t = injected.dequeue();
+  queued.fetch_sub(1);
+  return true;
+}
+
+
+inline void ForkJoinPool::run(Task* t) {
+  TaskGroup* g = t->group;
+  try {
+    t->f();
+  } catch (...) {
+    if (!g->failed.exchange(true))
+      g->error = std::current_exception();
+  }
+  delete t;
+  g->pending.fetch_sub(1, std::memory_order_release);   //Last: then sync may return (and g be destroyed)
+}
+
+
+inline void ForkJoinPool::run_worker(int index) {
+  me().pool  = this;
+  me().index = index;
+  while (!stopping.load()) {
+    Task* t;
+    if (find_task(index,t)) {
+      run(t);
+      continue;
+    }
+
+    std::unique_lock<std::mutex> guard(lock);
+    sleeping.fetch_add(1);
+    wake.wait(guard, [this]{return stopping.load() || queued.load() > 0;});
+    sleeping.fetch_sub(1);
+  }
+}
+
+
+template<class F>
+void ForkJoinPool::split(TaskGroup& g, int low, int high, F& f, int grain) {
+  while (high-low > grain) {
+    int mid = low + (high-low)/2;
+    spawn(g, [this,&g,mid,high,&f,grain] {split(g,mid,high,f,grain);});
+    high = mid;
+  }
+  for (int i=low; i<high; ++i)
+    f(i);
+}
+
+}
+
+#endif /* FORK_JOIN_POOL_HPP_ */
@@ -4,8 +4,13 @@
 #include <string>
 #include <iostream>
 #include <initializer_list>
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <exception>
 #include "ics_exceptions.hpp"
 #include "pair.hpp"
+#include "fast_range.hpp"
 
 
 namespace ics {
@@ -47,6 +52,21 @@ template<class KEY,class T, int (*thash)(const KEY& a) = undefinedhash<KEY>> cla
     bool has_value  (const T& value) const;
     std::string str () const; //supplies useful debugging information; contrast to operator <<
 
+    //Parallel queries: the bins are split into chunks that threads workers claim until none remain
+    //(threads <= 0 means one per hardware thread). f/map_f/pred are called concurrently on different
+    //Entries, so they must not modify the map. If one throws, no more chunks are claimed, and the
+    //first exception is rethrown once all workers have stopped. Chunks are folded in whatever order
+    //workers claim them (and bins are unordered anyway), so combine(R,R) must be associative and
+    //commutative.
+    template <class F>
+    void parallel_for_each (F f, int threads = 0) const;
+
+    template <class R, class F, class C>
+    R    parallel_reduce   (const R& identity, F map_f, C combine, int threads = 0) const;
+
+    template <class P>
+    int  parallel_count_if (P pred, int threads = 0) const;
+
 
     //Commands
     T    put   (const KEY& key, const T& value);
@@ -115,6 +135,37 @@ template<class KEY,class T, int (*thash)(const KEY& a) = undefinedhash<KEY>> cla
     Iterator end   () const;
 
 
+    //Unchecked iterator for hot loops: no mod_count/dynamic_cast checks and no erase.
+    //The map must not be changed while one is in use; see ics::fast above for a "for-each" loop
+    class FastIterator {
+      public:
+        HashMap<KEY,T,thash>::FastIterator& operator ++ ();
+        bool operator == (const HashMap<KEY,T,thash>::FastIterator& rhs) const;
+        bool operator != (const HashMap<KEY,T,thash>::FastIterator& rhs) const;
+        Entry& operator *  () const;
+        Entry* operator -> () const;
+
+        friend FastIterator HashMap<KEY,T,thash>::fast_begin () const;
+        friend FastIterator HashMap<KEY,T,thash>::fast_end   () const;
+
+      private:
+        LN** map;                //map/bins copied from the HashMap, so ++ need not dereference it
+        int  bins;
+        int  bin     = -1;
+        LN*  current = nullptr;  //stop: current == nullptr
+
+        //Helper methods
+        void next_bin();
+
+        //Called in friends fast_begin/fast_end
+        FastIterator(const HashMap<KEY,T,thash>* iterate_over, bool from_begin);
+    };
+
+
+    FastIterator fast_begin () const;
+    FastIterator fast_end   () const;
+
+
   private:
     class LN {
     public:
@@ -142,6 +193,10 @@ template<class KEY,class T, int (*thash)(const KEY& a) = undefinedhash<KEY>> cla
 
   void  ensure_load_threshold(int new_used);                   //Reallocate if load_factor > load_threshold
   void  delete_hash_table    (LN**& ht, int bins);             //Deallocate all LN in ht (and the ht itself; ht == nullptr)
+
+  int   worker_count         (int threads)             const;  //Actual # of workers used by the parallel_ queries
+  template <class S>
+  void  parallel_bins        (S scan, int workers)     const;  //Call scan(worker,low_bin,high_bin) on all chunks
 };
 
 
@@ -299,6 +354,53 @@ std::string HashMap<KEY,T,thash>::str() const {
 }
 
 
+template<class KEY,class T, int (*thash)(const KEY& a)>
+template <class F>
+void HashMap<KEY,T,thash>::parallel_for_each (F f, int threads) const {
+  parallel_bins([&] (int w, int low, int high) {
+                  for (int b=low; b<high; ++b)
+                    for (LN* c = map[b]; c->next!=nullptr; c=c->next)
+                      f(c->value);
+                },
+                worker_count(threads));
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a)>
+template <class R, class F, class C>
+R HashMap<KEY,T,thash>::parallel_reduce (const R& identity, F map_f, C combine, int threads) const {
+  //One accumulator per worker: no locking needed. Each is wrapped in a Partial so R need not be
+  //  default-constructible and std::vector<bool> (whose elements share words) is never used
+  struct Partial {R value;};
+  int workers = worker_count(threads);
+  std::vector<Partial> partial(workers,Partial{identity});
+
+  parallel_bins([&] (int w, int low, int high) {
+                  R chunk = identity; //Accumulate locally, so workers rarely write to shared cache lines
+                  for (int b=low; b<high; ++b)
+                    for (LN* c = map[b]; c->next!=nullptr; c=c->next)
+                      chunk = combine(chunk,map_f(c->value));
+                  partial[w].value = combine(partial[w].value,chunk);
+                },
+                workers);
+
+  R answer = identity;
+  for (int w=0; w<workers; ++w)
+    answer = combine(answer,partial[w].value);
+  return answer;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a)>
+template <class P>
+int HashMap<KEY,T,thash>::parallel_count_if (P pred, int threads) const {
+  return parallel_reduce(0,
+                         [&] (const Entry& e) {return pred(e) ? 1 : 0;},
+                         [] (int a, int b) {return a+b;},
+                         threads);
+}
+
+
 ////////////////////////////////////////////////////////////////////////////////
 //
 //Commands
@@ -484,6 +586,18 @@ auto HashMap<KEY,T,thash>::end () const -> HashMap<KEY,T,thash>::Iterator {
 }
 
 
+template<class KEY,class T, int (*thash)(const KEY& a)>
+auto HashMap<KEY,T,thash>::fast_begin () const -> HashMap<KEY,T,thash>::FastIterator {
+  return FastIterator(this,true);
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a)>
+auto HashMap<KEY,T,thash>::fast_end () const -> HashMap<KEY,T,thash>::FastIterator {
+  return FastIterator(this,false);
+}
+
+
 ////////////////////////////////////////////////////////////////////////////////
 //
 //Private helper methods
@@ -577,6 +691,58 @@ void HashMap<KEY,T,thash>::delete_hash_table (LN**& ht, int bins) {
 }
 
 
+template<class KEY,class T, int (*thash)(const KEY& a)>
+int HashMap<KEY,T,thash>::worker_count (int threads) const {
+  if (threads <= 0)
+    threads = std::max(1,int(std::thread::hardware_concurrency()));
+  return std::min(threads,bins);
+}
+
+
+//If scan throws (or a helper thread cannot be started), next_low jumps past the last bin so no
+//  more chunks are claimed; the helpers that were started are always joined (a joinable
+//  std::thread's destructor calls std::terminate), then the first exception is rethrown.
+//These threads are not a ForkJoinPool's: see fork_join_pool.hpp
+template<class KEY,class T, int (*thash)(const KEY& a)>
+template <class S>
+void HashMap<KEY,T,thash>::parallel_bins (S scan, int workers) const {
+  //Many more chunks than workers, so a worker stuck on long bins leaves the rest to the others
+  int chunk = std::max(1,bins/(8*workers));
+  std::atomic<int>   next_low(0);
+  std::atomic<bool>  failed(false);
+  std::exception_ptr error;
+  auto fail = [&] () {
+    if (!failed.exchange(true))
+      error = std::current_exception();
+    next_low.store(bins);
+  };
+  auto work = [&] (int w) {
+    try {
+      for (int low = next_low.fetch_add(chunk); low < bins; low = next_low.fetch_add(chunk))
+        scan(w, low, std::min(bins,low+chunk));
+    } catch (...) {
+      fail();
+    }
+  };
+
+  std::thread* helpers = new std::thread[workers-1];
+  int started = 0;
+  try {
+    for (; started < workers-1; ++started)
+      helpers[started] = std::thread(work,started+1);
+  } catch (...) {
+    fail();
+  }
+  work(0);                          //The calling thread is worker 0
+  for (int w=0; w<started; ++w)
+    helpers[w].join();
+  delete[] helpers;
+
+  if (failed.load())
+    std::rethrow_exception(error);
+}
+
+
 
 
 
@@ -733,6 +899,65 @@ pair<KEY,T>* HashMap<KEY,T,thash>::Iterator::operator ->() const {
 }
 
 
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//FastIterator class definitions
+
+template<class KEY,class T, int (*thash)(const KEY& a)>
+void HashMap<KEY,T,thash>::FastIterator::next_bin() {
+  for (++bin; bin<bins; ++bin)
+    if (map[bin]->next != nullptr) {
+      current = map[bin];
+      return;
+    }
+
+  current = nullptr;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a)>
+HashMap<KEY,T,thash>::FastIterator::FastIterator(const HashMap<KEY,T,thash>* iterate_over, bool from_begin)
+: map(iterate_over->map), bins(iterate_over->bins) {
+  if (from_begin)
+    next_bin();
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a)>
+auto HashMap<KEY,T,thash>::FastIterator::operator ++ () -> HashMap<KEY,T,thash>::FastIterator& {
+  current = current->next;
+  if (current->next == nullptr)   //reached the bin's trailer
+    next_bin();
+  return *this;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a)>
+bool HashMap<KEY,T,thash>::FastIterator::operator == (const HashMap<KEY,T,thash>::FastIterator& rhs) const {
+  return current == rhs.current;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a)>
+bool HashMap<KEY,T,thash>::FastIterator::operator != (const HashMap<KEY,T,thash>::FastIterator& rhs) const {
+  return current != rhs.current;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a)>
+pair<KEY,T>& HashMap<KEY,T,thash>::FastIterator::operator *() const {
+  return current->value;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a)>
+pair<KEY,T>* HashMap<KEY,T,thash>::FastIterator::operator ->() const {
+  return &(current->value);
+}
+
+
 }
 
 #endif /* HASH_MAP_HPP_ */
@@ -7,6 +7,7 @@
 #include <initializer_list>
 #include "ics_exceptions.hpp"
 #include "pair.hpp"
+#include "fast_range.hpp"
 
 
 namespace ics {
@@ -126,6 +127,37 @@ template<class T, int (*thash)(const T& a) = undefinedhash<T>> class HashSet {
     Iterator end   () const;
 
 
+    //Unchecked iterator for hot loops: no mod_count/dynamic_cast checks and no erase.
+    //The set must not be changed while one is in use; see ics::fast above for a "for-each" loop
+    class FastIterator {
+      public:
+        HashSet<T,thash>::FastIterator& operator ++ ();
+        bool operator == (const HashSet<T,thash>::FastIterator& rhs) const;
+        bool operator != (const HashSet<T,thash>::FastIterator& rhs) const;
+        T& operator *  () const;
+        T* operator -> () const;
+
+        friend FastIterator HashSet<T,thash>::fast_begin () const;
+        friend FastIterator HashSet<T,thash>::fast_end   () const;
+
+      private:
+        LN** set;                //set/bins copied from the HashSet, so ++ need not dereference it
+        int  bins;
+        int  bin     = -1;
+        LN*  current = nullptr;  //stop: current == nullptr
+
+        //Helper methods
+        void next_bin();
+
+        //Called in friends fast_begin/fast_end
+        FastIterator(const HashSet<T,thash>* iterate_over, bool from_begin);
+    };
+
+
+    FastIterator fast_begin () const;
+    FastIterator fast_end   () const;
+
+
   private:
     class LN {
       public:
@@ -531,6 +563,18 @@ auto HashSet<T,thash>::end () const -> HashSet<T,thash>::Iterator {
 }
 
 
+template<class T, int (*thash)(const T& a)>
+auto HashSet<T,thash>::fast_begin () const -> HashSet<T,thash>::FastIterator {
+  return FastIterator(this,true);
+}
+
+
+template<class T, int (*thash)(const T& a)>
+auto HashSet<T,thash>::fast_end () const -> HashSet<T,thash>::FastIterator {
+  return FastIterator(this,false);
+}
+
+
 ////////////////////////////////////////////////////////////////////////////////
 //
 //Private helper methods
@@ -776,6 +820,65 @@ T* HashSet<T,thash>::Iterator::operator ->() const {
   return &(current.second->value);
 }
 
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//FastIterator class definitions
+
+template<class T, int (*thash)(const T& a)>
+void HashSet<T,thash>::FastIterator::next_bin() {
+  for (++bin; bin<bins; ++bin)
+    if (set[bin]->next != nullptr) {
+      current = set[bin];
+      return;
+    }
+
+  current = nullptr;
+}
+
+
+template<class T, int (*thash)(const T& a)>
+HashSet<T,thash>::FastIterator::FastIterator(const HashSet<T,thash>* iterate_over, bool from_begin)
+: set(iterate_over->set), bins(iterate_over->bins) {
+  if (from_begin)
+    next_bin();
+}
+
+
+template<class T, int (*thash)(const T& a)>
+auto HashSet<T,thash>::FastIterator::operator ++ () -> HashSet<T,thash>::FastIterator& {
+  current = current->next;
+  if (current->next == nullptr)   //reached the bin's trailer
+    next_bin();
+  return *this;
+}
+
+
+template<class T, int (*thash)(const T& a)>
+bool HashSet<T,thash>::FastIterator::operator == (const HashSet<T,thash>::FastIterator& rhs) const {
+  return current == rhs.current;
+}
+
+
+template<class T, int (*thash)(const T& a)>
+bool HashSet<T,thash>::FastIterator::operator != (const HashSet<T,thash>::FastIterator& rhs) const {
+  return current != rhs.current;
+}
+
+
+template<class T, int (*thash)(const T& a)>
+T& HashSet<T,thash>::FastIterator::operator *() const {
+  return current->value;
+}
+
+
+template<class T, int (*thash)(const T& a)>
+T* HashSet<T,thash>::FastIterator::operator ->() const {
+  return &(current->value);
+}
+
 }
 
 #endif /* HASH_SET_HPP_ */
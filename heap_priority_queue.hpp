@@ -7,7 +7,11 @@
 #include <initializer_list>
 #include "ics_exceptions.hpp"
 #include <utility>              //For std::swap function
+#include <algorithm>            //For std::max/std::min
+#include <new>                  //For placement new (see allocate)
+#include <cstdint>              //For std::uintptr_t (see allocate)
 #include "array_stack.hpp"      //See operator <<
+#include "priority_queue_equal.hpp"
 
 
 namespace ics {
@@ -24,7 +28,11 @@ bool undefinedgt (const T& a, const T& b) {return false;}
 //If both tgt and cgt are supplied, then they must be the same (by ==) function.
 //If neither is supplied, or both are supplied but different, TemplateFunctionError is raised.
 //The (unique) non-undefinedgt value supplied by tgt/cgt is stored in the instance variable gt.
-template<class T, bool (*tgt)(const T& a, const T& b) = undefinedgt<T>> class HeapPriorityQueue {
+//arity is the # of children per heap node: 4 or 8 halve or third the depth that percolate_down
+//  walks, and (with the cache-line-aligned storage below) keep all siblings in one cache line.
+template<class T, bool (*tgt)(const T& a, const T& b) = undefinedgt<T>, int arity = 2> class HeapPriorityQueue {
+  static_assert(arity >= 2, "HeapPriorityQueue: arity must be at least 2");
+
   public:
     typedef bool (*gtfunc) (const T& a, const T& b);
         
@@ -33,7 +41,7 @@ template<class T, bool (*tgt)(const T& a, const T& b) = undefinedgt<T>> class He
 
     HeapPriorityQueue(bool (*cgt)(const T& a, const T& b) = undefinedgt<T>);
     explicit HeapPriorityQueue(int initial_length, bool (*cgt)(const T& a, const T& b) = undefinedgt<T>);
-    HeapPriorityQueue(const HeapPriorityQueue<T,tgt>& to_copy, bool (*cgt)(const T& a, const T& b) = undefinedgt<T>);
+    HeapPriorityQueue(const HeapPriorityQueue<T,tgt,arity>& to_copy, bool (*cgt)(const T& a, const T& b) = undefinedgt<T>);
     explicit HeapPriorityQueue(const std::initializer_list<T>& il, bool (*cgt)(const T& a, const T& b) = undefinedgt<T>);
 
     //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
@@ -46,12 +54,19 @@ template<class T, bool (*tgt)(const T& a, const T& b) = undefinedgt<T>> class He
     int  size       () const;
     T&   peek       () const;
     std::string str () const; //supplies useful debugging information; contrast to operator <<
+    int  top_k      (int k, T* buffer) const; //buffer[0..k) = k highest, in order; returns # stored
 
 
     //Commands
     int  enqueue (const T& element);
-    T    dequeue ();
+    int  enqueue (T&& element);
+    template <class... Args>
+    int  emplace (Args&&... args);               //constructs the value in place from args
+    T    dequeue ();                             //moves the value out
+    T    replace_top (const T& element);         //dequeue then enqueue element, with one percolate_down
+    T    replace_top (T&& element);
     void clear   ();
+    int  drain_sorted_into (T* buffer);  //buffer[0..size()) = all values, highest first; leaves queue empty
 
     //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
     template <class Iterable>
@@ -59,46 +74,61 @@ template<class T, bool (*tgt)(const T& a, const T& b) = undefinedgt<T>> class He
 
 
     //Operators
-    HeapPriorityQueue<T,tgt>& operator = (const HeapPriorityQueue<T,tgt>& rhs);
-    bool operator == (const HeapPriorityQueue<T,tgt>& rhs) const;
-    bool operator != (const HeapPriorityQueue<T,tgt>& rhs) const;
+    HeapPriorityQueue<T,tgt,arity>& operator = (const HeapPriorityQueue<T,tgt,arity>& rhs);
+    bool operator == (const HeapPriorityQueue<T,tgt,arity>& rhs) const;
+    bool operator != (const HeapPriorityQueue<T,tgt,arity>& rhs) const;
 
-    template<class T2, bool (*gt2)(const T2& a, const T2& b)>
-    friend std::ostream& operator << (std::ostream& outs, const HeapPriorityQueue<T2,gt2>& pq);
+    template<class T2, bool (*gt2)(const T2& a, const T2& b), int arity2>
+    friend std::ostream& operator << (std::ostream& outs, const HeapPriorityQueue<T2,gt2,arity2>& pq);
 
 
 
+    //Iterates in priority order without copying the heap: a small "frontier" heap of indexes into
+    //  pq holds the roots of the subtrees not yet visited, so reaching the k-th value costs
+    //  O(k log k) time and O(k) space. After the first erase the unvisited values are copied
+    //  (as the original Iterator did for all of them) and iteration continues on that copy.
     class Iterator {
       public:
-        //Private constructor called in begin/end, which are friends of HeapPriorityQueue<T,tgt>
+        //Private constructor called in begin/end, which are friends of HeapPriorityQueue<T,tgt,arity>
         ~Iterator();
+        Iterator(const HeapPriorityQueue<T,tgt,arity>::Iterator& to_copy);
+        HeapPriorityQueue<T,tgt,arity>::Iterator& operator = (const HeapPriorityQueue<T,tgt,arity>::Iterator& rhs);
         T           erase();
         std::string str  () const;
-        HeapPriorityQueue<T,tgt>::Iterator& operator ++ ();
-        HeapPriorityQueue<T,tgt>::Iterator  operator ++ (int);
-        bool operator == (const HeapPriorityQueue<T,tgt>::Iterator& rhs) const;
-        bool operator != (const HeapPriorityQueue<T,tgt>::Iterator& rhs) const;
+        HeapPriorityQueue<T,tgt,arity>::Iterator& operator ++ ();
+        HeapPriorityQueue<T,tgt,arity>::Iterator  operator ++ (int);
+        bool operator == (const HeapPriorityQueue<T,tgt,arity>::Iterator& rhs) const;
+        bool operator != (const HeapPriorityQueue<T,tgt,arity>::Iterator& rhs) const;
         T& operator *  () const;
         T* operator -> () const;
-        friend std::ostream& operator << (std::ostream& outs, const HeapPriorityQueue<T,tgt>::Iterator& i) {
+        friend std::ostream& operator << (std::ostream& outs, const HeapPriorityQueue<T,tgt,arity>::Iterator& i) {
           outs << i.str(); //Use the same meaning as the debugging .str() method
           return outs;
         }
 
-        friend Iterator HeapPriorityQueue<T,tgt>::begin () const;
-        friend Iterator HeapPriorityQueue<T,tgt>::end   () const;
+        friend Iterator HeapPriorityQueue<T,tgt,arity>::begin () const;
+        friend Iterator HeapPriorityQueue<T,tgt,arity>::end   () const;
 
       private:
-        //If can_erase is false, the value has been removed from "it" (++ does nothing)
-        HeapPriorityQueue<T,tgt>  it;                 //copy of HPQ (from begin), to use as iterator via dequeue
-        HeapPriorityQueue<T,tgt>* ref_pq;
-        int                       expected_mod_count;
-        bool                      can_erase = true;
+        //If can_erase is false, the value has been removed (++ only sets can_erase back to true)
+        HeapPriorityQueue<T,tgt,arity>* ref_pq;
+        int*                            frontier        = nullptr; //heap of indexes into ref_pq->pq; top is current
+        int                             frontier_length = 0;
+        int                             frontier_used   = 0;
+        HeapPriorityQueue<T,tgt,arity>* it              = nullptr; //copy of unvisited values, after an erase
+        int                             remaining;                 //# values not yet passed (including current)
+        int                             expected_mod_count;
+        bool                            can_erase = true;
+
+        //Helper methods
+        bool frontier_higher (int i, int j) const;  //compare the pq values indexed by frontier[i]/frontier[j]
+        void frontier_push   (int index);
+        void frontier_pop    ();
+        void advance         ();                    //visit current: replace it in frontier by its children
+        void copy_unvisited  ();                    //build it from the frontier's subtrees (but not current)
 
         //Called in friends begin/end
-        //These constructors have different initializers (see it(...) in first one)
-        Iterator(HeapPriorityQueue<T,tgt>* iterate_over, bool from_begin);    // Called by begin
-        Iterator(HeapPriorityQueue<T,tgt>* iterate_over);                     // Called by end
+        Iterator(HeapPriorityQueue<T,tgt,arity>* iterate_over, bool from_begin);
     };
 
 
@@ -107,23 +137,34 @@ template<class T, bool (*tgt)(const T& a, const T& b) = undefinedgt<T>> class He
 
 
   private:
+    static const int cache_line = 64;    //Bytes; storage for pq starts on this boundary (see allocate)
+
     bool (*gt) (const T& a, const T& b); // The gt used by enqueue (from template or constructor)
-    T*  pq;                              // Array represents a heap, so it uses heap ordering property
+    T*    pq;                            // Array represents a heap, so it uses heap ordering property
+    void* block;                         // Raw memory holding pq (from allocate): only pq[0..used) are constructed
     int length    = 0;                   //Physical length of array: must be >= .size()
     int used      = 0;                   //Amount of array used:  invariant: 0 <= used <= length
     int mod_count = 0;                   //For sensing concurrent modification
 
 
     //Helper methods
+    static T*   allocate   (int length, void*& block);        //Cache-line-aligned, unconstructed storage for length Ts
+    static void deallocate (T* pq, int used, void* block);    //Destroy pq[0..used) and free storage from allocate
     void ensure_length  (int new_length);
-    int  left_child     (int i) const;         //Useful abstractions for heaps as arrays
-    int  right_child    (int i) const;
-    int  parent         (int i) const;
+    template <class... Args>
+    void append         (Args&&... args);      //Construct pq[used++] from args (which may refer into pq)
+    template <class Iterable>                  //i.size() if Iterable has a size(); otherwise 0
+    static auto size_hint (const Iterable& i, int)  -> decltype(int(i.size())) {return i.size();}
+    template <class Iterable>
+    static int  size_hint (const Iterable& i, long) {return 0;}
+    int  first_child    (int i) const;         //Useful abstractions for heaps as arrays:
+    int  parent         (int i) const;         //  children of i are first_child(i)..first_child(i)+arity-1
     bool is_root        (int i) const;
     bool in_heap        (int i) const;
-    void percolate_up   (int i);
+    void percolate_up   (int i);               //Both move a "hole" (not swap values) along the path
     void percolate_down (int i);
     void heapify        ();                   // Percolate down all value is array (from indexes used-1 to 0): O(N)
+    void restore_appended (int old_used);     // Restore heap order after appending pq[old_used..used)
   };
 
 
@@ -136,26 +177,26 @@ template<class T, bool (*tgt)(const T& a, const T& b) = undefinedgt<T>> class He
 
 //Destructor/Constructors
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-HeapPriorityQueue<T,tgt>::~HeapPriorityQueue() {
-  delete[] pq;
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+HeapPriorityQueue<T,tgt,arity>::~HeapPriorityQueue() {
+  deallocate(pq,used,block);
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-HeapPriorityQueue<T,tgt>::HeapPriorityQueue(bool (*cgt)(const T& a, const T& b))
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+HeapPriorityQueue<T,tgt,arity>::HeapPriorityQueue(bool (*cgt)(const T& a, const T& b))
 : gt(tgt != (gtfunc)undefinedgt<T> ? tgt : cgt) {
   if (gt == (gtfunc)undefinedgt<T>)
     throw TemplateFunctionError("HeapPriorityQueue::default constructor: neither specified");
   if (tgt != (gtfunc)undefinedgt<T> && cgt != (gtfunc)undefinedgt<T> && tgt != cgt)
     throw TemplateFunctionError("HeapPriorityQueue::default constructor: both specified and different");
 
-  pq = new T[length];
+  pq = allocate(length,block);
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-HeapPriorityQueue<T,tgt>::HeapPriorityQueue(int initial_length, bool (*cgt)(const T& a, const T& b))
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+HeapPriorityQueue<T,tgt,arity>::HeapPriorityQueue(int initial_length, bool (*cgt)(const T& a, const T& b))
 : gt(tgt != (gtfunc)undefinedgt<T> ? tgt : cgt), length(initial_length) {
   if (gt == (gtfunc)undefinedgt<T>)
     throw TemplateFunctionError("HeapPriorityQueue::length constructor: neither specified");
@@ -164,60 +205,54 @@ HeapPriorityQueue<T,tgt>::HeapPriorityQueue(int initial_length, bool (*cgt)(cons
 
   if (length < 0)
     length = 0;
-  pq = new T[length];
+  pq = allocate(length,block);
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-HeapPriorityQueue<T,tgt>::HeapPriorityQueue(const HeapPriorityQueue<T,tgt>& to_copy, bool (*cgt)(const T& a, const T& b))
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+HeapPriorityQueue<T,tgt,arity>::HeapPriorityQueue(const HeapPriorityQueue<T,tgt,arity>& to_copy, bool (*cgt)(const T& a, const T& b))
 : gt(tgt != (gtfunc)undefinedgt<T> ? tgt : cgt), length(to_copy.length), used(to_copy.used) {
   if (gt == (gtfunc)undefinedgt<T>)
     gt = to_copy.gt;//throw TemplateFunctionError("HeapPriorityQueue::copy constructor: neither specified");
   if (tgt != (gtfunc)undefinedgt<T> && cgt != (gtfunc)undefinedgt<T> && tgt != cgt)
     throw TemplateFunctionError("HeapPriorityQueue::copy constructor: both specified and different");
 
-  pq = new T[length];
+  pq = allocate(length,block);
   for (int i=0; i<to_copy.used; ++i)
-    pq[i] = to_copy.pq[i];
+    new (pq+i) T(to_copy.pq[i]);
 
   if (gt != to_copy.gt)
     heapify();
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-HeapPriorityQueue<T,tgt>::HeapPriorityQueue(const std::initializer_list<T>& il, bool (*cgt)(const T& a, const T& b))
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+HeapPriorityQueue<T,tgt,arity>::HeapPriorityQueue(const std::initializer_list<T>& il, bool (*cgt)(const T& a, const T& b))
 : gt(tgt != (gtfunc)undefinedgt<T> ? tgt : cgt), length(il.size()) {
   if (gt == (gtfunc)undefinedgt<T>)
     throw TemplateFunctionError("HeapPriorityQueue::initializer_list constructor: neither specified");
   if (tgt != (gtfunc)undefinedgt<T> && cgt != (gtfunc)undefinedgt<T> && tgt != cgt)
     throw TemplateFunctionError("HeapPriorityQueue::initializer_list constructor: both specified and different");
 
-  pq = new T[length];
-  int i = 0;
-  for (const T& pq_elem : il) {
-    pq[i++] = pq_elem;
-  }
-  used = length;
+  pq = allocate(length,block);
+  for (const T& pq_elem : il)
+    new (pq+used++) T(pq_elem);
   heapify();
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
 template<class Iterable>
-HeapPriorityQueue<T,tgt>::HeapPriorityQueue(const Iterable& i, bool (*cgt)(const T& a, const T& b))
+HeapPriorityQueue<T,tgt,arity>::HeapPriorityQueue(const Iterable& i, bool (*cgt)(const T& a, const T& b))
 : gt(tgt != (gtfunc)undefinedgt<T> ? tgt : cgt), length(i.size()) {
   if (gt == (gtfunc)undefinedgt<T>)
     throw TemplateFunctionError("HeapPriorityQueue::Iterable constructor: neither specified");
   if (tgt != (gtfunc)undefinedgt<T> && cgt != (gtfunc)undefinedgt<T> && tgt != cgt)
     throw TemplateFunctionError("HeapPriorityQueue::Iterable constructor: both specified and different");
 
-  pq = new T[length];
-  int j = 0;
-  for (const T& pq_elem : i) {
-    pq[j++] = pq_elem;
-  }
-  used = length;
+  pq = allocate(length,block);
+  for (const T& pq_elem : i)
+    new (pq+used++) T(pq_elem);
   heapify();
 }
 
@@ -226,20 +261,20 @@ HeapPriorityQueue<T,tgt>::HeapPriorityQueue(const Iterable& i, bool (*cgt)(const
 //
 //Queries
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-bool HeapPriorityQueue<T,tgt>::empty() const {
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+bool HeapPriorityQueue<T,tgt,arity>::empty() const {
   return used == 0;
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-int HeapPriorityQueue<T,tgt>::size() const {
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+int HeapPriorityQueue<T,tgt,arity>::size() const {
   return used;
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-T& HeapPriorityQueue<T,tgt>::peek () const {
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+T& HeapPriorityQueue<T,tgt,arity>::peek () const {
   if (empty())
     throw EmptyError("HeapPriorityQueue::peek");
 
@@ -247,14 +282,14 @@ T& HeapPriorityQueue<T,tgt>::peek () const {
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-std::string HeapPriorityQueue<T,tgt>::str() const {
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+std::string HeapPriorityQueue<T,tgt,arity>::str() const {
   std::ostringstream answer;
   answer << "HeapPriorityQueue[";
 
-  if (length != 0) {
+  if (used != 0) {
     answer << "0:" << pq[0];
-    for (int i = 1; i < length; ++i)
+    for (int i = 1; i < used; ++i)
       answer << "," << i << ":" << pq[i];
   }
 
@@ -263,14 +298,33 @@ std::string HeapPriorityQueue<T,tgt>::str() const {
 }
 
 
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+int HeapPriorityQueue<T,tgt,arity>::top_k(int k, T* buffer) const {
+  int stored = 0;
+  for (Iterator i = begin(); stored < k && i != end(); ++i)
+    buffer[stored++] = *i;
+
+  return stored;
+}
+
+
 ////////////////////////////////////////////////////////////////////////////////
 //
 //Commands
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-int HeapPriorityQueue<T,tgt>::enqueue(const T& element) {
-  this->ensure_length(used+1);
-  pq[used++] = element;
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+int HeapPriorityQueue<T,tgt,arity>::enqueue(const T& element) {
+  append(element);
+
+  this->percolate_up(used-1);
+  ++mod_count;
+  return 1;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+int HeapPriorityQueue<T,tgt,arity>::enqueue(T&& element) {
+  append(std::move(element));
 
   this->percolate_up(used-1);
   ++mod_count;
@@ -278,14 +332,60 @@ int HeapPriorityQueue<T,tgt>::enqueue(const T& element) {
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-T HeapPriorityQueue<T,tgt>::dequeue() {
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+template <class... Args>
+int HeapPriorityQueue<T,tgt,arity>::emplace(Args&&... args) {
+  append(std::forward<Args>(args)...);
+
+  this->percolate_up(used-1);
+  ++mod_count;
+  return 1;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+T HeapPriorityQueue<T,tgt,arity>::dequeue() {
   if (this->empty())
     throw EmptyError("HeapPriorityQueue::dequeue");
 
-  T to_return = pq[0];
-  pq[0] = pq[--used];
+  T to_return = std::move(pq[0]);
+  if (--used != 0)
+    pq[0] = std::move(pq[used]);
+  pq[used].~T();
+
+  if (used != 0)
+    percolate_down(0);
+
+  ++mod_count;
+  return to_return;
+}
+
+
+//Overwrite the root and percolate it down; returns the old root (element may be a value in pq,
+//  so the root is replaced by itself without moving it out)
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+T HeapPriorityQueue<T,tgt,arity>::replace_top(const T& element) {
+  if (this->empty())
+    throw EmptyError("HeapPriorityQueue::replace_top");
+
+  T to_return = (&element == pq ? element : std::move(pq[0]));
+  if (&element != pq)
+    pq[0] = element;
+  percolate_down(0);
+
+  ++mod_count;
+  return to_return;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+T HeapPriorityQueue<T,tgt,arity>::replace_top(T&& element) {
+  if (this->empty())
+    throw EmptyError("HeapPriorityQueue::replace_top");
 
+  T to_return = (&element == pq ? T(pq[0]) : std::move(pq[0]));
+  if (&element != pq)
+    pq[0] = std::move(element);
   percolate_down(0);
 
   ++mod_count;
@@ -293,21 +393,58 @@ T HeapPriorityQueue<T,tgt>::dequeue() {
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-void HeapPriorityQueue<T,tgt>::clear() {
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+void HeapPriorityQueue<T,tgt,arity>::clear() {
+  for (int i=0; i<used; ++i)
+    pq[i].~T();
   used = 0;
   ++mod_count;
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
+//In-place heapsort: repeatedly swap the root to the end of the shrinking heap, leaving pq
+//  ordered from lowest to highest priority; then copy it out highest first
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+int HeapPriorityQueue<T,tgt,arity>::drain_sorted_into(T* buffer) {
+  int n = used;
+  while (used > 1) {
+    std::swap(pq[0],pq[--used]);
+    percolate_down(0);
+  }
+
+  for (int i=0; i<n; ++i) {
+    buffer[i] = std::move(pq[n-1-i]);
+    pq[n-1-i].~T();
+  }
+  used = 0;
+  ++mod_count;
+  return n;
+}
+
+
+//Append all values (after one ensure_length if i has a size()), then restore the heap once (see
+//  restore_appended). Enqueueing a queue into itself appends a copy of its old values: iterating
+//  over it while appending would visit the appended values too.
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
 template <class Iterable>
-int HeapPriorityQueue<T,tgt>::enqueue_all (const Iterable& i) {
-  int count = 0;
-  for (const T& v : i)
-     count += enqueue(v);
+int HeapPriorityQueue<T,tgt,arity>::enqueue_all (const Iterable& i) {
+  int old_used = used;
+  if (static_cast<const void*>(&i) == static_cast<const void*>(this)) {
+    this->ensure_length(2*used);
+    for (int j=0; j<old_used; ++j)
+      new (pq+used++) T(pq[j]);
+  }else{
+    this->ensure_length(used+size_hint(i,0));
+    for (const T& v : i) {
+      if (used == length)
+        this->ensure_length(used+1);
+      new (pq+used++) T(v);
+    }
+  }
 
-  return count;
+  restore_appended(old_used);
+  ++mod_count;
+  return used-old_used;
 }
 
 
@@ -315,47 +452,66 @@ int HeapPriorityQueue<T,tgt>::enqueue_all (const Iterable& i) {
 //
 //Operators
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-HeapPriorityQueue<T,tgt>& HeapPriorityQueue<T,tgt>::operator = (const HeapPriorityQueue<T,tgt>& rhs) {
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+HeapPriorityQueue<T,tgt,arity>& HeapPriorityQueue<T,tgt,arity>::operator = (const HeapPriorityQueue<T,tgt,arity>& rhs) {
   if (this == &rhs)
     return *this;
 
   gt = rhs.gt;   // if tgt != nullptr, gts are already equal (or compiler error)
-  this->ensure_length(rhs.used);
-  used = rhs.used;
-  for (int i=0; i<rhs.used; ++i)
+  if (length < rhs.used) {   //Nothing to move to the new storage: discard the old values first
+    deallocate(pq,used,block);
+    used   = 0;
+    length = rhs.used;
+    pq     = allocate(length,block);
+  }
+
+  //Assign over the values both have; construct or destroy the rest
+  int common = std::min(used,rhs.used);
+  for (int i=0; i<common; ++i)
     pq[i] = rhs.pq[i];
+  for (int i=common; i<rhs.used; ++i)
+    new (pq+i) T(rhs.pq[i]);
+  for (int i=rhs.used; i<used; ++i)
+    pq[i].~T();
+  used = rhs.used;
 
   ++mod_count;
   return *this;
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-bool HeapPriorityQueue<T,tgt>::operator == (const HeapPriorityQueue<T,tgt>& rhs) const {
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+bool HeapPriorityQueue<T,tgt,arity>::operator == (const HeapPriorityQueue<T,tgt,arity>& rhs) const {
   if (this == &rhs)
     return true;
   if (gt != rhs.gt) //For PriorityQueues to be equal, they need the same gt function, and values
     return false;
   if (used != rhs.size())
     return false;
-  HeapPriorityQueue<T,tgt>::Iterator l = this->begin(), r = rhs.begin();
-  for (int i=0; i<used; ++i, ++l, ++r)
-    if (*l != *r)
-      return false;
 
-  return true;
+  //Compare pointers to the values (not copies of them) in priority order
+  const T** l = new const T*[used];
+  const T** r = new const T*[used];
+  for (int i=0; i<used; ++i) {
+    l[i] = &pq[i];
+    r[i] = &rhs.pq[i];
+  }
+  bool answer = priority_queue_equal(l,r,used,gt);
+
+  delete[] l;
+  delete[] r;
+  return answer;
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-bool HeapPriorityQueue<T,tgt>::operator != (const HeapPriorityQueue<T,tgt>& rhs) const {
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+bool HeapPriorityQueue<T,tgt,arity>::operator != (const HeapPriorityQueue<T,tgt,arity>& rhs) const {
   return !(*this == rhs);
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-std::ostream& operator << (std::ostream& outs, const HeapPriorityQueue<T,tgt>& p) {
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+std::ostream& operator << (std::ostream& outs, const HeapPriorityQueue<T,tgt,arity>& p) {
   outs << "priority_queue[";
 
   if (!p.empty()) {
@@ -374,15 +530,15 @@ std::ostream& operator << (std::ostream& outs, const HeapPriorityQueue<T,tgt>& p
 //
 //Iterator constructors
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-auto HeapPriorityQueue<T,tgt>::begin () const -> HeapPriorityQueue<T,tgt>::Iterator {
-    return Iterator(const_cast<HeapPriorityQueue<T,tgt>*>(this),true);
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+auto HeapPriorityQueue<T,tgt,arity>::begin () const -> HeapPriorityQueue<T,tgt,arity>::Iterator {
+    return Iterator(const_cast<HeapPriorityQueue<T,tgt,arity>*>(this),true);
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-auto HeapPriorityQueue<T,tgt>::end () const -> HeapPriorityQueue<T,tgt>::Iterator {
-  return Iterator(const_cast<HeapPriorityQueue<T,tgt>*>(this),false);  //Create empty pq (size == 0)
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+auto HeapPriorityQueue<T,tgt,arity>::end () const -> HeapPriorityQueue<T,tgt,arity>::Iterator {
+  return Iterator(const_cast<HeapPriorityQueue<T,tgt,arity>*>(this),false);  //Nothing remaining
 }
 
 
@@ -390,138 +546,280 @@ auto HeapPriorityQueue<T,tgt>::end () const -> HeapPriorityQueue<T,tgt>::Iterato
 //
 //Private helper methods
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-void HeapPriorityQueue<T,tgt>::ensure_length(int new_length) {
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+T* HeapPriorityQueue<T,tgt,arity>::allocate(int length, void*& block) {
+  //Start the array arity-1 slots past a cache line boundary: then the children of node i, at
+  //  arity*i+1..arity*i+arity, begin at slot arity*(i+1) from the boundary, so a group of
+  //  siblings never straddles more cache lines than it must (just one if arity*sizeof(T)
+  //  divides cache_line)
+//Nothing is constructed: values are placement-new'd into pq[used] as they are added
+  std::size_t align = std::max<std::size_t>(cache_line,alignof(T));
+  block = ::operator new((length+arity-1)*sizeof(T) + align);
+  std::uintptr_t base = (reinterpret_cast<std::uintptr_t>(block) + align-1) / align * align;
+  return reinterpret_cast<T*>(base) + (arity-1);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+void HeapPriorityQueue<T,tgt,arity>::deallocate(T* pq, int used, void* block) {
+  for (int i=0; i<used; ++i)
+    pq[i].~T();
+  ::operator delete(block);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+void HeapPriorityQueue<T,tgt,arity>::ensure_length(int new_length) {
   if (length >= new_length)
     return;
-  T*  old_pq  = pq;
+  T*    old_pq     = pq;
+  void* old_block  = block;
   length = std::max(new_length,2*length);
-  pq = new T[length];
+  pq = allocate(length,block);
   for (int i=0; i<used; ++i)
-    pq[i] = old_pq[i];
+    new (pq+i) T(std::move(old_pq[i]));
 
-  delete [] old_pq;
+  deallocate(old_pq,used,old_block);
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-int HeapPriorityQueue<T,tgt>::left_child(int i) const
-{return 2*i+1;}
+//When pq is full, the new value is constructed in the new storage before the old values are moved
+//  there and destroyed: args may refer to one of them (as in q.enqueue(q.peek()))
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+template <class... Args>
+void HeapPriorityQueue<T,tgt,arity>::append(Args&&... args) {
+  if (used < length) {
+    new (pq+used++) T(std::forward<Args>(args)...);
+    return;
+  }
+
+  int   new_length = std::max(used+1,2*length);
+  void* new_block;
+  T*    new_pq     = allocate(new_length,new_block);
+  new (new_pq+used) T(std::forward<Args>(args)...);
+  for (int i=0; i<used; ++i)
+    new (new_pq+i) T(std::move(pq[i]));
+
+  deallocate(pq,used,block);
+  pq     = new_pq;
+  block  = new_block;
+  length = new_length;
+  ++used;
+}
+
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-int HeapPriorityQueue<T,tgt>::right_child(int i) const
-{return 2*i+2;}
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+int HeapPriorityQueue<T,tgt,arity>::first_child(int i) const
+{return arity*i+1;}
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-int HeapPriorityQueue<T,tgt>::parent(int i) const
-{return (i-1)/2;}
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+int HeapPriorityQueue<T,tgt,arity>::parent(int i) const
+{return (i-1)/arity;}
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-bool HeapPriorityQueue<T,tgt>::is_root(int i) const
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+bool HeapPriorityQueue<T,tgt,arity>::is_root(int i) const
 {return i == 0;}
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-bool HeapPriorityQueue<T,tgt>::in_heap(int i) const
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+bool HeapPriorityQueue<T,tgt,arity>::in_heap(int i) const
 {return i < used;}
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-void HeapPriorityQueue<T,tgt>::percolate_up(int i) {
-  for (/*parameter*/; !is_root(i) && gt(pq[i],pq[parent(i)]); i = parent(i))
-    std::swap(pq[parent(i)],pq[i]);
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+void HeapPriorityQueue<T,tgt,arity>::percolate_up(int i) {
+  if (is_root(i) || !gt(pq[i],pq[parent(i)]))
+    return;
+
+  //Move each lower parent down into the hole; store the value once, where the hole stops
+  T value = std::move(pq[i]);
+  for (/*parameter*/; !is_root(i) && gt(value,pq[parent(i)]); i = parent(i))
+    pq[i] = std::move(pq[parent(i)]);
+  pq[i] = std::move(value);
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-void HeapPriorityQueue<T,tgt>::percolate_down(int i) {
-  for (int l = left_child(i); in_heap(l); l = left_child(i)) {
-    int r = right_child(i);
-    int max_child = (!in_heap(r) || gt(pq[l],pq[r]) ? l : r);
-    if ( gt(pq[i],pq[max_child]) )
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+void HeapPriorityQueue<T,tgt,arity>::percolate_down(int i) {
+  if (!in_heap(first_child(i)))
+    return;
+
+  //Move each higher child up into the hole; store the value once, where the hole stops
+  T value = std::move(pq[i]);
+  for (int f = first_child(i); in_heap(f); f = first_child(i)) {
+    int max_child = f;
+    int last      = std::min(f+arity,used);
+    for (int c = f+1; c < last; ++c)
+      if (gt(pq[c],pq[max_child]))
+        max_child = c;
+    if ( gt(value,pq[max_child]) )
        break;
-    std::swap(pq[i],pq[max_child]);
+    pq[i] = std::move(pq[max_child]);
     i = max_child;
   }
+  pq[i] = std::move(value);
 }
 
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-void HeapPriorityQueue<T,tgt>::heapify() {
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+void HeapPriorityQueue<T,tgt,arity>::heapify() {
 for (int i = used-1; i >= 0; --i)
   percolate_down(i);
 }
 
 
+//For m = used-old_used appended values, choose the cheapest way to restore the heap:
+//  m >= old_used:   full heapify, O(used)
+//  m <= height:     percolate_up each, O(m log used) but usually O(m) on random data
+//  otherwise:       partial heapify: percolate_down only the ancestors of the appended values,
+//                   level by level; at each level they form the contiguous range of the parents
+//                   of the level below, so the total work is about m/(arity-1) + height^2
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+void HeapPriorityQueue<T,tgt,arity>::restore_appended(int old_used) {
+  int m = used-old_used;
+  if (m == 0)
+    return;
+  if (m >= old_used) {
+    heapify();
+    return;
+  }
+
+  int height = 0;
+  for (int i = used-1; !is_root(i); i = parent(i))
+    ++height;
+  if (m <= height) {
+    for (int i = old_used; i < used; ++i)
+      percolate_up(i);
+    return;
+  }
+
+  //Processing each range from high to low (and ranges bottom up) percolates every node down
+  //  only after all its changed descendants, as heapify does
+  for (int low = old_used, high = used-1; !is_root(high); /*see body*/) {
+    low  = parent(low);
+    high = parent(high);
+    for (int i = high; i >= low; --i)
+      percolate_down(i);
+  }
+}
+
+
 ////////////////////////////////////////////////////////////////////////////////
 //
 //Iterator class definitions
 
-//template<class T, bool (*tgt)(const T& a, const T& b)>
-//HeapPriorityQueue<T,tgt>::Iterator::Iterator(HeapPriorityQueue<T,tgt>* iterate_over, bool from_begin)
-//: it(*iterate_over,iterate_over->gt), ref_pq(iterate_over), expected_mod_count(iterate_over->mod_count) {
-//  // Full priority queue; use copy constructor
-//}
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+HeapPriorityQueue<T,tgt,arity>::Iterator::Iterator(HeapPriorityQueue<T,tgt,arity>* iterate_over, bool from_begin)
+: ref_pq(iterate_over), remaining(from_begin ? iterate_over->used : 0), expected_mod_count(iterate_over->mod_count) {
+  if (remaining != 0)
+    frontier_push(0);   //Start with only the root: the whole heap is unvisited
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+HeapPriorityQueue<T,tgt,arity>::Iterator::Iterator(const HeapPriorityQueue<T,tgt,arity>::Iterator& to_copy)
+: ref_pq(to_copy.ref_pq), frontier_length(to_copy.frontier_used), frontier_used(to_copy.frontier_used),
+  remaining(to_copy.remaining), expected_mod_count(to_copy.expected_mod_count), can_erase(to_copy.can_erase) {
+  if (frontier_length != 0) {
+    frontier = new int[frontier_length];
+    for (int i=0; i<frontier_used; ++i)
+      frontier[i] = to_copy.frontier[i];
+  }
+  if (to_copy.it != nullptr)
+    it = new HeapPriorityQueue<T,tgt,arity>(*to_copy.it);
+}
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-HeapPriorityQueue<T,tgt>::Iterator::Iterator(HeapPriorityQueue<T,tgt>* iterate_over, bool from_begin)
-: it(iterate_over->gt), ref_pq(iterate_over), expected_mod_count(iterate_over->mod_count) {
-  if (from_begin)
-    it = *iterate_over;// Empty priority queue; use default constructor (from declaration of "it")
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+HeapPriorityQueue<T,tgt,arity>::Iterator::~Iterator() {
+  delete[] frontier;
+  delete it;
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-HeapPriorityQueue<T,tgt>::Iterator::~Iterator()
-{}
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+auto HeapPriorityQueue<T,tgt,arity>::Iterator::operator = (const HeapPriorityQueue<T,tgt,arity>::Iterator& rhs) -> HeapPriorityQueue<T,tgt,arity>::Iterator& {
+  if (this == &rhs)
+    return *this;
+
+  Iterator copy(rhs);
+  std::swap(ref_pq,            copy.ref_pq);
+  std::swap(frontier,          copy.frontier);
+  std::swap(frontier_length,   copy.frontier_length);
+  std::swap(frontier_used,     copy.frontier_used);
+  std::swap(it,                copy.it);
+  std::swap(remaining,         copy.remaining);
+  std::swap(expected_mod_count,copy.expected_mod_count);
+  std::swap(can_erase,         copy.can_erase);
+  return *this;
+}
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-T HeapPriorityQueue<T,tgt>::Iterator::erase() {
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+T HeapPriorityQueue<T,tgt,arity>::Iterator::erase() {
   if (expected_mod_count != ref_pq->mod_count)
     throw ConcurrentModificationError("HeapPriorityQueue::Iterator::erase");
   if (!can_erase)
     throw CannotEraseError("HeapPriorityQueue::Iterator::erase Iterator cursor already erased");
-  if (it.empty())
+  if (remaining == 0)
     throw CannotEraseError("HeapPriorityQueue::Iterator::erase Iterator cursor beyond data structure");
 
   can_erase = false;
-  T to_return = it.dequeue();
+  --remaining;
+  int i = -1;     //Index of the erased value in ref_pq->pq
+  T to_return;
+  if (it == nullptr) {
+    i = frontier[0];
+    to_return = std::move(ref_pq->pq[i]);  //copy_unvisited skips current, so it may be moved out
+    copy_unvisited();  //ref_pq's indexes change below, so the frontier is no longer usable
+  }else {
+    //Find value from it (heap iterating over) in main heap
+    to_return = it->dequeue();
+    for (int j=0; j<ref_pq->used; ++j)
+      if (ref_pq->pq[j] == to_return) {
+        i = j;
+        break;
+      }
+  }
 
-  //Find value from it (heap iterating over) in main heap; percolate it
-  for (int i=0; i<ref_pq->used; ++i)
-    if (ref_pq->pq[i] == to_return) {
-      ref_pq->pq[i] = ref_pq->pq[--ref_pq->used];
+  if (i != -1) {
+    int last = --ref_pq->used;
+    if (i != last)
+      ref_pq->pq[i] = std::move(ref_pq->pq[last]);
+    ref_pq->pq[last].~T();
+    if (i != last) {
       ref_pq->percolate_up(i);
       ref_pq->percolate_down(i);
-      break;
     }
+  }
 
-  expected_mod_count = ref_pq->mod_count;
+  expected_mod_count = ++ref_pq->mod_count;
   return to_return;
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-std::string HeapPriorityQueue<T,tgt>::Iterator::str() const {
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+std::string HeapPriorityQueue<T,tgt,arity>::Iterator::str() const {
   std::ostringstream answer;
-  answer << it.str() << "/expected_mod_count=" << expected_mod_count << "/can_erase=" << can_erase;
+  answer << ref_pq->str() << "(frontier=";
+  for (int i=0; i<frontier_used; ++i)
+    answer << (i == 0 ? "" : ",") << frontier[i];
+  answer << ",copied=" << (it != nullptr) << ",remaining=" << remaining
+         << ",expected_mod_count=" << expected_mod_count << ",can_erase=" << can_erase << ")";
   return answer.str();
 }
 
 
-
-template<class T, bool (*tgt)(const T& a, const T& b)>
-auto HeapPriorityQueue<T,tgt>::Iterator::operator ++ () -> HeapPriorityQueue<T,tgt>::Iterator& {
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+auto HeapPriorityQueue<T,tgt,arity>::Iterator::operator ++ () -> HeapPriorityQueue<T,tgt,arity>::Iterator& {
 if (expected_mod_count != ref_pq->mod_count)
     throw ConcurrentModificationError("HeapPriorityQueue::Iterator::operator ++");
 
-  if (it.empty())
+  if (remaining == 0)
     return *this;
 
   if (can_erase)
-    it.dequeue();
+    advance();
   else
     can_erase = true;
 
@@ -529,17 +827,17 @@ if (expected_mod_count != ref_pq->mod_count)
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-auto HeapPriorityQueue<T,tgt>::Iterator::operator ++ (int) -> HeapPriorityQueue<T,tgt>::Iterator {
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+auto HeapPriorityQueue<T,tgt,arity>::Iterator::operator ++ (int) -> HeapPriorityQueue<T,tgt,arity>::Iterator {
   if (expected_mod_count != ref_pq->mod_count)
     throw ConcurrentModificationError("HeapPriorityQueue::Iterator::operator ++(int)");
 
-  if (it.empty())
+  if (remaining == 0)
     return *this;
 
   Iterator to_return(*this);
   if (can_erase)
-    it.dequeue();
+    advance();
   else
     can_erase = true;
 
@@ -547,8 +845,8 @@ auto HeapPriorityQueue<T,tgt>::Iterator::operator ++ (int) -> HeapPriorityQueue<
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-bool HeapPriorityQueue<T,tgt>::Iterator::operator == (const HeapPriorityQueue<T,tgt>::Iterator& rhs) const {
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+bool HeapPriorityQueue<T,tgt,arity>::Iterator::operator == (const HeapPriorityQueue<T,tgt,arity>::Iterator& rhs) const {
   const Iterator* rhsASI = dynamic_cast<const Iterator*>(&rhs);
   if (rhsASI == 0)
     throw IteratorTypeError("HeapPriorityQueue::Iterator::operator ==");
@@ -557,13 +855,13 @@ bool HeapPriorityQueue<T,tgt>::Iterator::operator == (const HeapPriorityQueue<T,
   if (ref_pq != rhsASI->ref_pq)
     throw ComparingDifferentIteratorsError("HeapPriorityQueue::Iterator::operator ==");
 
-  //Two iterators on the same heap are equal if their sizes are equal
-  return this->it.size() == rhsASI->it.size();
+  //Two iterators on the same heap are equal if they have the same number of values remaining
+  return this->remaining == rhsASI->remaining;
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-bool HeapPriorityQueue<T,tgt>::Iterator::operator != (const HeapPriorityQueue<T,tgt>::Iterator& rhs) const {
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+bool HeapPriorityQueue<T,tgt,arity>::Iterator::operator != (const HeapPriorityQueue<T,tgt,arity>::Iterator& rhs) const {
   const Iterator* rhsASI = dynamic_cast<const Iterator*>(&rhs);
   if (rhsASI == 0)
     throw IteratorTypeError("HeapPriorityQueue::Iterator::operator !=");
@@ -572,29 +870,115 @@ bool HeapPriorityQueue<T,tgt>::Iterator::operator != (const HeapPriorityQueue<T,
   if (ref_pq != rhsASI->ref_pq)
     throw ComparingDifferentIteratorsError("HeapPriorityQueue::Iterator::operator !=");
 
-  return this->it.size() != rhsASI->it.size();
+  return this->remaining != rhsASI->remaining;
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-T& HeapPriorityQueue<T,tgt>::Iterator::operator *() const {
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+T& HeapPriorityQueue<T,tgt,arity>::Iterator::operator *() const {
   if (expected_mod_count != ref_pq->mod_count)
     throw ConcurrentModificationError("HeapPriorityQueue::Iterator::operator *");
-  if (!can_erase || it.empty())
+  if (!can_erase || remaining == 0)
     throw IteratorPositionIllegal("HeapPriorityQueue::Iterator::operator * Iterator illegal");
 
-  return it.peek();
+  return it == nullptr ? ref_pq->pq[frontier[0]] : it->peek();
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-T* HeapPriorityQueue<T,tgt>::Iterator::operator ->() const {
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+T* HeapPriorityQueue<T,tgt,arity>::Iterator::operator ->() const {
   if (expected_mod_count != ref_pq->mod_count)
     throw ConcurrentModificationError("HeapPriorityQueue::Iterator::operator *");
-  if (!can_erase || it.empty())
+  if (!can_erase || remaining == 0)
     throw IteratorPositionIllegal("HeapPriorityQueue::Iterator::operator -> Iterator illegal");
 
-  return &it.peek();
+  return it == nullptr ? &ref_pq->pq[frontier[0]] : &it->peek();
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+bool HeapPriorityQueue<T,tgt,arity>::Iterator::frontier_higher(int i, int j) const {
+  return ref_pq->gt(ref_pq->pq[frontier[i]],ref_pq->pq[frontier[j]]);
+}
+
+
+//The frontier is a binary heap (any arity works; it stays small)
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+void HeapPriorityQueue<T,tgt,arity>::Iterator::frontier_push(int index) {
+  if (frontier_used == frontier_length) {
+    int* old_frontier = frontier;
+    frontier_length = std::max(2*frontier_length,arity+1);
+    frontier = new int[frontier_length];
+    for (int i=0; i<frontier_used; ++i)
+      frontier[i] = old_frontier[i];
+    delete[] old_frontier;
+  }
+
+  int i = frontier_used++;
+  frontier[i] = index;
+  for (/*see above*/; i != 0 && frontier_higher(i,(i-1)/2); i = (i-1)/2)
+    std::swap(frontier[i],frontier[(i-1)/2]);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+void HeapPriorityQueue<T,tgt,arity>::Iterator::frontier_pop() {
+  frontier[0] = frontier[--frontier_used];
+  for (int i = 0, l = 1; l < frontier_used; l = 2*i+1) {
+    int max_child = (l+1 >= frontier_used || frontier_higher(l,l+1) ? l : l+1);
+    if (frontier_higher(i,max_child))
+      break;
+    std::swap(frontier[i],frontier[max_child]);
+    i = max_child;
+  }
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+void HeapPriorityQueue<T,tgt,arity>::Iterator::advance() {
+  --remaining;
+  if (it != nullptr) {
+    it->dequeue();
+    return;
+  }
+
+  int current = frontier[0];
+  frontier_pop();
+  int last = std::min(ref_pq->first_child(current)+arity,ref_pq->used);
+  for (int c = ref_pq->first_child(current); c < last; ++c)
+    frontier_push(c);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+void HeapPriorityQueue<T,tgt,arity>::Iterator::copy_unvisited() {
+  it = new HeapPriorityQueue<T,tgt,arity>(remaining,ref_pq->gt);
+
+  //Every unvisited value is in the subtree of some frontier index; skip current (frontier[0])
+  //  but not its children. Each unvisited index is pushed on the stack exactly once.
+  int* stack = new int[remaining+1];
+  int  top   = 0;
+  for (int f=1; f<frontier_used; ++f)
+    stack[top++] = frontier[f];
+  int current = frontier[0];
+  int last    = std::min(ref_pq->first_child(current)+arity,ref_pq->used);
+  for (int c = ref_pq->first_child(current); c < last; ++c)
+    stack[top++] = c;
+
+  while (top != 0) {
+    int i = stack[--top];
+    new (it->pq + it->used++) T(ref_pq->pq[i]);
+    last = std::min(ref_pq->first_child(i)+arity,ref_pq->used);
+    for (int c = ref_pq->first_child(i); c < last; ++c)
+      stack[top++] = c;
+  }
+  delete[] stack;
+  it->heapify();
+
+  delete[] frontier;
+  frontier        = nullptr;
+  frontier_length = 0;
+  frontier_used   = 0;
 }
 
 }
@@ -0,0 +1,625 @@
+#ifndef INDEXED_HEAP_PRIORITY_QUEUE_HPP_
+#define INDEXED_HEAP_PRIORITY_QUEUE_HPP_
+
+#include <string>
+#include <iostream>
+#include <sstream>
+#include <initializer_list>
+#include "ics_exceptions.hpp"
+#include <utility>              //For std::swap function
+#include <algorithm>            //For std::max/std::min
+#include "array_stack.hpp"      //See operator <<
+#include "priority_queue_equal.hpp"
+
+
+namespace ics {
+
+
+#ifndef undefinedgtdefined
+#define undefinedgtdefined
+template<class T>
+bool undefinedgt (const T& a, const T& b) {return false;}
+#endif /* undefinedgtdefined */
+
+//An addressable heap: enqueue returns a Handle that names its value until that value is dequeued
+//  or erased; update/erase/contains on a Handle are O(log N)/O(log N)/O(1) because a position map
+//  (slot -> index in pq) is maintained alongside the heap.
+//The slots of removed values are reused by later enqueues, but each carries a generation count
+//  (also in its Handles), so a stale Handle is recognized: contains is false, and update/erase/
+//  operator [] throw KeyError.
+//
+//Instantiate the templated class supplying tgt(a,b): true, iff a has higher priority than b.
+//If tgt is defaulted to undefinedgt in the template, then a constructor must supply cgt.
+//If both tgt and cgt are supplied, then they must be the same (by ==) function.
+//If neither is supplied, or both are supplied but different, TemplateFunctionError is raised.
+//The (unique) non-undefinedgt value supplied by tgt/cgt is stored in the instance variable gt.
+template<class T, bool (*tgt)(const T& a, const T& b) = undefinedgt<T>, int arity = 2> class IndexedHeapPriorityQueue {
+  static_assert(arity >= 2, "IndexedHeapPriorityQueue: arity must be at least 2");
+
+  public:
+    typedef bool (*gtfunc) (const T& a, const T& b);
+
+    class Handle {
+      public:
+        Handle() {}                       //Names no value
+        bool operator == (const Handle& rhs) const {return slot == rhs.slot && generation == rhs.generation;}
+        bool operator != (const Handle& rhs) const {return !(*this == rhs);}
+      private:
+        Handle(int slot, int generation) : slot(slot), generation(generation) {}
+        int slot       = -1;
+        int generation = 0;
+        friend class IndexedHeapPriorityQueue<T,tgt,arity>;
+    };
+
+    //Destructor/Constructors
+    ~IndexedHeapPriorityQueue();
+
+    IndexedHeapPriorityQueue(bool (*cgt)(const T& a, const T& b) = undefinedgt<T>);
+    explicit IndexedHeapPriorityQueue(int initial_length, bool (*cgt)(const T& a, const T& b) = undefinedgt<T>);
+    IndexedHeapPriorityQueue(const IndexedHeapPriorityQueue<T,tgt,arity>& to_copy, bool (*cgt)(const T& a, const T& b) = undefinedgt<T>);
+    explicit IndexedHeapPriorityQueue(const std::initializer_list<T>& il, bool (*cgt)(const T& a, const T& b) = undefinedgt<T>);
+
+    //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
+    template <class Iterable>
+    explicit IndexedHeapPriorityQueue (const Iterable& i, bool (*cgt)(const T& a, const T& b) = undefinedgt<T>);
+
+
+    //Queries
+    bool empty       () const;
+    int  size        () const;
+    bool contains    (Handle handle) const;
+    const T& peek    () const;
+    Handle peek_handle () const; //handle of the value peek returns
+    std::string str  () const; //supplies useful debugging information; contrast to operator <<
+
+
+    //Commands
+    Handle enqueue (const T& element);                //returns the handle naming element
+    T      dequeue ();
+    T      update  (Handle handle, const T& new_value);  //returns old value; percolates up or down as needed
+    T      erase   (Handle handle);
+    void   clear   ();
+
+    //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
+    template <class Iterable>
+    int enqueue_all (const Iterable& i);
+
+
+    //Operators
+    const T& operator [] (Handle handle) const;  //No T& version: changing a value must go through update
+    IndexedHeapPriorityQueue<T,tgt,arity>& operator = (const IndexedHeapPriorityQueue<T,tgt,arity>& rhs);
+    bool operator == (const IndexedHeapPriorityQueue<T,tgt,arity>& rhs) const;
+    bool operator != (const IndexedHeapPriorityQueue<T,tgt,arity>& rhs) const;
+
+    template<class T2, bool (*gt2)(const T2& a, const T2& b), int arity2>
+    friend std::ostream& operator << (std::ostream& outs, const IndexedHeapPriorityQueue<T2,gt2,arity2>& pq);
+
+
+  private:
+    bool (*gt) (const T& a, const T& b); // The gt used by enqueue (from template or constructor)
+    int* pq;                             // Heap of slots, ordered by the values they hold
+    T*   values;                         // values[h] is the value in slot h
+    int* position;                       // position[h] is the index of h in pq; -1 if h is free
+    int* generation;                     // generation[h] is incremented each time slot h is freed
+    int* free_handles;                   // Stack of slots available for reuse
+    int length    = 0;                   //Physical length of all arrays: must be >= .size()
+    int used      = 0;                   //Amount of pq used:  invariant: 0 <= used <= length
+    int free_used = 0;                   //Amount of free_handles used
+    int next_new  = 0;                   //Slots next_new..length-1 are not in use or in free_handles
+    int mod_count = 0;                   //For sensing concurrent modification
+
+
+    //Helper methods
+    void allocate       (int new_length);      //Allocate all arrays with length new_length
+    void deallocate     ();
+    void copy_from      (const IndexedHeapPriorityQueue<T,tgt,arity>& from);  //Same slots as from (length >= from.length); not generations
+    void ensure_length  (int new_length);
+    int  new_handle     ();                    //A free slot
+    void check_handle   (Handle handle, const char* where) const;  //KeyError if handle not in queue
+    T    remove_at      (int i);               //Remove the slot at pq[i] (freeing it) and return its value
+    int  first_child    (int i) const;         //Useful abstractions for heaps as arrays
+    int  parent         (int i) const;
+    bool is_root        (int i) const;
+    bool in_heap        (int i) const;
+    bool higher         (int i, int j) const;  //gt on the values named by pq[i] and pq[j]
+    void swap_at        (int i, int j);        //swap pq[i]/pq[j] and fix their positions
+    void percolate_up   (int i);
+    void percolate_down (int i);
+    void heapify        ();
+};
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//IndexedHeapPriorityQueue class and related definitions
+
+//Destructor/Constructors
+
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+IndexedHeapPriorityQueue<T,tgt,arity>::~IndexedHeapPriorityQueue() {
+  deallocate();
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+IndexedHeapPriorityQueue<T,tgt,arity>::IndexedHeapPriorityQueue(bool (*cgt)(const T& a, const T& b))
+: gt(tgt != (gtfunc)undefinedgt<T> ? tgt : cgt) {
+  if (gt == (gtfunc)undefinedgt<T>)
+    throw TemplateFunctionError("IndexedHeapPriorityQueue::default constructor: neither specified");
+  if (tgt != (gtfunc)undefinedgt<T> && cgt != (gtfunc)undefinedgt<T> && tgt != cgt)
+    throw TemplateFunctionError("IndexedHeapPriorityQueue::default constructor: both specified and different");
+
+  allocate(0);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+IndexedHeapPriorityQueue<T,tgt,arity>::IndexedHeapPriorityQueue(int initial_length, bool (*cgt)(const T& a, const T& b))
+: gt(tgt != (gtfunc)undefinedgt<T> ? tgt : cgt) {
+  if (gt == (gtfunc)undefinedgt<T>)
+    throw TemplateFunctionError("IndexedHeapPriorityQueue::length constructor: neither specified");
+  if (tgt != (gtfunc)undefinedgt<T> && cgt != (gtfunc)undefinedgt<T> && tgt != cgt)
+    throw TemplateFunctionError("IndexedHeapPriorityQueue::length constructor: both specified and different");
+
+  allocate(std::max(0,initial_length));
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+IndexedHeapPriorityQueue<T,tgt,arity>::IndexedHeapPriorityQueue(const IndexedHeapPriorityQueue<T,tgt,arity>& to_copy, bool (*cgt)(const T& a, const T& b))
+: gt(tgt != (gtfunc)undefinedgt<T> ? tgt : cgt) {
+  if (gt == (gtfunc)undefinedgt<T>)
+    gt = to_copy.gt;//throw TemplateFunctionError("IndexedHeapPriorityQueue::copy constructor: neither specified");
+  if (tgt != (gtfunc)undefinedgt<T> && cgt != (gtfunc)undefinedgt<T> && tgt != cgt)
+    throw TemplateFunctionError("IndexedHeapPriorityQueue::copy constructor: both specified and different");
+
+  allocate(to_copy.length);
+  copy_from(to_copy);
+  for (int h=0; h<to_copy.length; ++h)
+    generation[h] = to_copy.generation[h];
+
+  if (gt != to_copy.gt)
+    heapify();
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+IndexedHeapPriorityQueue<T,tgt,arity>::IndexedHeapPriorityQueue(const std::initializer_list<T>& il, bool (*cgt)(const T& a, const T& b))
+: gt(tgt != (gtfunc)undefinedgt<T> ? tgt : cgt) {
+  if (gt == (gtfunc)undefinedgt<T>)
+    throw TemplateFunctionError("IndexedHeapPriorityQueue::initializer_list constructor: neither specified");
+  if (tgt != (gtfunc)undefinedgt<T> && cgt != (gtfunc)undefinedgt<T> && tgt != cgt)
+    throw TemplateFunctionError("IndexedHeapPriorityQueue::initializer_list constructor: both specified and different");
+
+  allocate(il.size());
+  for (const T& pq_elem : il) {
+    values[used] = pq_elem;
+    pq[used] = position[used] = used;
+    ++used;
+  }
+  next_new = used;
+  heapify();
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+template<class Iterable>
+IndexedHeapPriorityQueue<T,tgt,arity>::IndexedHeapPriorityQueue(const Iterable& i, bool (*cgt)(const T& a, const T& b))
+: gt(tgt != (gtfunc)undefinedgt<T> ? tgt : cgt) {
+  if (gt == (gtfunc)undefinedgt<T>)
+    throw TemplateFunctionError("IndexedHeapPriorityQueue::Iterable constructor: neither specified");
+  if (tgt != (gtfunc)undefinedgt<T> && cgt != (gtfunc)undefinedgt<T> && tgt != cgt)
+    throw TemplateFunctionError("IndexedHeapPriorityQueue::Iterable constructor: both specified and different");
+
+  allocate(i.size());
+  for (const T& pq_elem : i) {
+    values[used] = pq_elem;
+    pq[used] = position[used] = used;
+    ++used;
+  }
+  next_new = used;
+  heapify();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Queries
+
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+bool IndexedHeapPriorityQueue<T,tgt,arity>::empty() const {
+  return used == 0;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+int IndexedHeapPriorityQueue<T,tgt,arity>::size() const {
+  return used;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+bool IndexedHeapPriorityQueue<T,tgt,arity>::contains(Handle handle) const {
+  return handle.slot >= 0 && handle.slot < next_new && position[handle.slot] != -1 && generation[handle.slot] == handle.generation;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+const T& IndexedHeapPriorityQueue<T,tgt,arity>::peek () const {
+  if (empty())
+    throw EmptyError("IndexedHeapPriorityQueue::peek");
+
+  return values[pq[0]];
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+auto IndexedHeapPriorityQueue<T,tgt,arity>::peek_handle () const -> Handle {
+  if (empty())
+    throw EmptyError("IndexedHeapPriorityQueue::peek_handle");
+
+  return Handle(pq[0],generation[pq[0]]);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+std::string IndexedHeapPriorityQueue<T,tgt,arity>::str() const {
+  std::ostringstream answer;
+  answer << "IndexedHeapPriorityQueue[";
+
+  if (used != 0) {
+    answer << "0:" << pq[0] << "=" << values[pq[0]];
+    for (int i = 1; i < used; ++i)
+      answer << "," << i << ":" << pq[i] << "=" << values[pq[i]];
+  }
+
+  answer << "](length=" << length << ",used=" << used << ",free_used=" << free_used << ",next_new=" << next_new << ",mod_count=" << mod_count << ")";
+  return answer.str();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Commands
+
+//element may be a value in this queue (as in q.enqueue(q.peek())): if the arrays must grow, copy it
+//  first, as growing frees the old values
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+auto IndexedHeapPriorityQueue<T,tgt,arity>::enqueue(const T& element) -> Handle {
+  if (free_used == 0 && next_new == length) {
+    T copy(element);
+    ensure_length(next_new+1);
+    return enqueue(copy);
+  }
+
+  int h = new_handle();
+  values[h] = element;
+  pq[used] = h;
+  position[h] = used++;
+
+  percolate_up(used-1);
+  ++mod_count;
+  return Handle(h,generation[h]);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+T IndexedHeapPriorityQueue<T,tgt,arity>::dequeue() {
+  if (this->empty())
+    throw EmptyError("IndexedHeapPriorityQueue::dequeue");
+
+  ++mod_count;
+  return remove_at(0);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+T IndexedHeapPriorityQueue<T,tgt,arity>::update(Handle handle, const T& new_value) {
+  check_handle(handle,"update");
+
+  T to_return = values[handle.slot];
+  values[handle.slot] = new_value;
+  int i = position[handle.slot];
+  if (gt(new_value,to_return))
+    percolate_up(i);
+  else
+    percolate_down(i);
+
+  ++mod_count;
+  return to_return;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+T IndexedHeapPriorityQueue<T,tgt,arity>::erase(Handle handle) {
+  check_handle(handle,"erase");
+
+  ++mod_count;
+  return remove_at(position[handle.slot]);
+}
+
+
+//Slots keep their generations (even those >= next_new), so no Handle from before clear is valid
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+void IndexedHeapPriorityQueue<T,tgt,arity>::clear() {
+  for (int h=0; h<next_new; ++h)
+    if (position[h] != -1) {
+      position[h] = -1;
+      ++generation[h];
+    }
+  used      = 0;
+  free_used = 0;
+  next_new  = 0;
+  ++mod_count;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+template <class Iterable>
+int IndexedHeapPriorityQueue<T,tgt,arity>::enqueue_all (const Iterable& i) {
+  int count = 0;
+  for (const T& v : i) {
+    enqueue(v);
+    ++count;
+  }
+
+  return count;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Operators
+
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+const T& IndexedHeapPriorityQueue<T,tgt,arity>::operator [] (Handle handle) const {
+  check_handle(handle,"operator []");
+  return values[handle.slot];
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+IndexedHeapPriorityQueue<T,tgt,arity>& IndexedHeapPriorityQueue<T,tgt,arity>::operator = (const IndexedHeapPriorityQueue<T,tgt,arity>& rhs) {
+  if (this == &rhs)
+    return *this;
+
+  //Keep (and grow) this queue's generations: clear bumps those of the live slots, so no Handle
+  //  from before the assignment names a value copied from rhs
+  gt = rhs.gt;   // if tgt != nullptr, gts are already equal (or compiler error)
+  clear();
+  ensure_length(rhs.length);
+  copy_from(rhs);
+
+  ++mod_count;
+  return *this;
+}
+
+
+//Equal if same gt and the same values (see priority_queue_equal); handles are not compared
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+bool IndexedHeapPriorityQueue<T,tgt,arity>::operator == (const IndexedHeapPriorityQueue<T,tgt,arity>& rhs) const {
+  if (this == &rhs)
+    return true;
+  if (gt != rhs.gt) //For PriorityQueues to be equal, they need the same gt function, and values
+    return false;
+  if (used != rhs.size())
+    return false;
+
+  const T** l = new const T*[used];
+  const T** r = new const T*[used];
+  for (int i=0; i<used; ++i) {
+    l[i] = &values[pq[i]];
+    r[i] = &rhs.values[rhs.pq[i]];
+  }
+  bool answer = priority_queue_equal(l,r,used,gt);
+
+  delete[] l;
+  delete[] r;
+  return answer;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+bool IndexedHeapPriorityQueue<T,tgt,arity>::operator != (const IndexedHeapPriorityQueue<T,tgt,arity>& rhs) const {
+  return !(*this == rhs);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+std::ostream& operator << (std::ostream& outs, const IndexedHeapPriorityQueue<T,tgt,arity>& p) {
+  outs << "priority_queue[";
+
+  if (!p.empty()) {
+    IndexedHeapPriorityQueue<T,tgt,arity> temp(p);
+    ArrayStack<T> st;
+    while (!temp.empty())
+      st.push(temp.dequeue());
+    outs << st.pop();
+    while (!st.empty())
+      outs << "," << st.pop();
+  }
+
+  outs << "]:highest";
+  return outs;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Private helper methods
+
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+void IndexedHeapPriorityQueue<T,tgt,arity>::allocate(int new_length) {
+  length       = new_length;
+  pq           = new int[length];
+  values       = new T[length];
+  position     = new int[length];
+  generation   = new int[length];
+  free_handles = new int[length];
+  for (int h=0; h<length; ++h)
+    generation[h] = 0;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+void IndexedHeapPriorityQueue<T,tgt,arity>::deallocate() {
+  delete[] pq;
+  delete[] values;
+  delete[] position;
+  delete[] generation;
+  delete[] free_handles;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+void IndexedHeapPriorityQueue<T,tgt,arity>::copy_from(const IndexedHeapPriorityQueue<T,tgt,arity>& from) {
+  used      = from.used;
+  free_used = from.free_used;
+  next_new  = from.next_new;
+  for (int i=0; i<used; ++i)
+    pq[i] = from.pq[i];
+  for (int h=0; h<next_new; ++h) {
+    position[h] = from.position[h];
+    if (position[h] != -1)
+      values[h] = from.values[h];
+  }
+  for (int f=0; f<free_used; ++f)
+    free_handles[f] = from.free_handles[f];
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+void IndexedHeapPriorityQueue<T,tgt,arity>::ensure_length(int new_length) {
+  if (length >= new_length)
+    return;
+  int* old_pq           = pq;
+  T*   old_values       = values;
+  int* old_position     = position;
+  int* old_generation   = generation;
+  int* old_free_handles = free_handles;
+  int  old_length       = length;
+
+  allocate(std::max(new_length,2*length));
+  for (int i=0; i<used; ++i)
+    pq[i] = old_pq[i];
+  for (int h=0; h<next_new; ++h) {
+    position[h] = old_position[h];
+    if (position[h] != -1)
+      values[h] = old_values[h];
+  }
+  for (int h=0; h<old_length; ++h)
+    generation[h] = old_generation[h];
+  for (int f=0; f<free_used; ++f)
+    free_handles[f] = old_free_handles[f];
+
+  delete[] old_pq;
+  delete[] old_values;
+  delete[] old_position;
+  delete[] old_generation;
+  delete[] old_free_handles;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+int IndexedHeapPriorityQueue<T,tgt,arity>::new_handle() {
+  if (free_used != 0)
+    return free_handles[--free_used];
+
+  ensure_length(next_new+1);
+  return next_new++;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+void IndexedHeapPriorityQueue<T,tgt,arity>::check_handle(Handle handle, const char* where) const {
+  if (!contains(handle)) {
+    std::ostringstream answer;
+    answer << "IndexedHeapPriorityQueue::" << where << ": handle(" << handle.slot << "/" << handle.generation << ") not in queue";
+    throw KeyError(answer.str());
+  }
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+T IndexedHeapPriorityQueue<T,tgt,arity>::remove_at(int i) {
+  int h = pq[i];
+  T to_return = values[h];
+  position[h] = -1;
+  ++generation[h];
+  free_handles[free_used++] = h;
+
+  if (i != --used) {
+    int moved = pq[i] = pq[used];   //Fill the hole with the last handle and percolate it either way
+    position[moved] = i;
+    percolate_up(i);
+    percolate_down(position[moved]);
+  }
+
+  return to_return;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+int IndexedHeapPriorityQueue<T,tgt,arity>::first_child(int i) const
+{return arity*i+1;}
+
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+int IndexedHeapPriorityQueue<T,tgt,arity>::parent(int i) const
+{return (i-1)/arity;}
+
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+bool IndexedHeapPriorityQueue<T,tgt,arity>::is_root(int i) const
+{return i == 0;}
+
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+bool IndexedHeapPriorityQueue<T,tgt,arity>::in_heap(int i) const
+{return i < used;}
+
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+bool IndexedHeapPriorityQueue<T,tgt,arity>::higher(int i, int j) const
+{return gt(values[pq[i]],values[pq[j]]);}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+void IndexedHeapPriorityQueue<T,tgt,arity>::swap_at(int i, int j) {
+  std::swap(pq[i],pq[j]);
+  position[pq[i]] = i;
+  position[pq[j]] = j;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+void IndexedHeapPriorityQueue<T,tgt,arity>::percolate_up(int i) {
+  for (/*parameter*/; !is_root(i) && higher(i,parent(i)); i = parent(i))
+    swap_at(parent(i),i);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+void IndexedHeapPriorityQueue<T,tgt,arity>::percolate_down(int i) {
+  for (int f = first_child(i); in_heap(f); f = first_child(i)) {
+    int max_child = f;
+    int last      = std::min(f+arity,used);
+    for (int c = f+1; c < last; ++c)
+      if (higher(c,max_child))
+        max_child = c;
+    if ( higher(i,max_child) )
+       break;
+    swap_at(i,max_child);
+    i = max_child;
+  }
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), int arity>
+void IndexedHeapPriorityQueue<T,tgt,arity>::heapify() {
+for (int i = used-1; i >= 0; --i)
+  percolate_down(i);
+}
+
+}
+
+#endif /* INDEXED_HEAP_PRIORITY_QUEUE_HPP_ */
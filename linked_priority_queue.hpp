@@ -7,6 +7,7 @@
 #include <initializer_list>
 #include "ics_exceptions.hpp"
 #include "array_stack.hpp"      //See operator <<
+#include "fast_range.hpp"
 
 
 namespace ics {
@@ -104,6 +105,31 @@ template<class T, bool (*tgt)(const T& a, const T& b) = undefinedgt<T>> class Li
     Iterator end   () const;
 
 
+    //Unchecked iterator for hot loops: no mod_count/dynamic_cast checks and no erase.
+    //The priority queue must not be changed while one is in use; see ics::fast above for a "for-each" loop
+    class FastIterator {
+      public:
+        LinkedPriorityQueue<T,tgt>::FastIterator& operator ++ ();
+        bool operator == (const LinkedPriorityQueue<T,tgt>::FastIterator& rhs) const;
+        bool operator != (const LinkedPriorityQueue<T,tgt>::FastIterator& rhs) const;
+        T& operator *  () const;
+        T* operator -> () const;
+
+        friend FastIterator LinkedPriorityQueue<T,tgt>::fast_begin () const;
+        friend FastIterator LinkedPriorityQueue<T,tgt>::fast_end   () const;
+
+      private:
+        LN* current;
+
+        //Called in friends fast_begin/fast_end
+        FastIterator(LN* initial);
+    };
+
+
+    FastIterator fast_begin () const;
+    FastIterator fast_end   () const;
+
+
   private:
     class LN {
       public:
@@ -123,6 +149,8 @@ template<class T, bool (*tgt)(const T& a, const T& b) = undefinedgt<T>> class Li
 
     //Helper methods
     void delete_list(LN*& front);        //Deallocate all LNs, and set front's argument to nullptr;
+    LN*  sort_chain (LN* chain, int n);  //Stable merge sort (by gt) of a chain of n LNs; returns its first LN
+    void merge_chain(LN* chain);         //Merge a sorted chain into the list, as enqueueing each would
 };
 
 
@@ -186,8 +214,7 @@ if (tgt != (bool (*)(const T& a, const T& b))undefinedgt<T> && cgt != (bool (*)(
     throw TemplateFunctionError("LinkedPriorityQueue::initializer_list constructor: both specified");
   }
 
-  for (const T& q_elem : il)
-    enqueue(q_elem);
+  enqueue_all(il);
 }
 
 
@@ -204,8 +231,7 @@ if (tgt != (bool (*)(const T& a, const T& b))undefinedgt<T> && cgt != (bool (*)(
     throw TemplateFunctionError("LinkedPriorityQueue::iterable constructor: both specified");
   }
 
-  for (const T& v : i)
-    enqueue(v);
+  enqueue_all(i);
 }
 
 
@@ -289,14 +315,27 @@ void LinkedPriorityQueue<T,tgt>::clear() {
 }
 
 
+//Enqueueing one at a time walks the list for each value: O(m*n). Instead chain the new values,
+//  sort the chain, and merge it in one pass: O(m log m + n).
+//enqueue puts a value before all values it has equal priority to, so later values come first:
+//  prepending reverses the values, which the stable sort keeps for equal ones, and merge_chain
+//  puts new values before existing equal ones.
 template<class T, bool (*tgt)(const T& a, const T& b)>
 template <class Iterable>
 int LinkedPriorityQueue<T,tgt>::enqueue_all (const Iterable& i) {
+  LN* chain = nullptr;
   int count = 0;
-  for (const T& v : i)
-     count += enqueue(v);
+  for (const T& v : i) {
+    chain = new LN(v,chain);
+    ++count;
+  }
+  if (count == 0)
+    return 0;
 
-    return count;
+  merge_chain(sort_chain(chain,count));
+  used += count;
+  ++mod_count;
+  return count;
 }
 
 
@@ -386,6 +425,18 @@ auto LinkedPriorityQueue<T,tgt>::end () const -> LinkedPriorityQueue<T,tgt>::Ite
 }
 
 
+template<class T, bool (*tgt)(const T& a, const T& b)>
+auto LinkedPriorityQueue<T,tgt>::fast_begin () const -> LinkedPriorityQueue<T,tgt>::FastIterator {
+  return FastIterator(front->next);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+auto LinkedPriorityQueue<T,tgt>::fast_end () const -> LinkedPriorityQueue<T,tgt>::FastIterator {
+  return FastIterator(nullptr);
+}
+
+
 ////////////////////////////////////////////////////////////////////////////////
 //
 //Private helper methods
@@ -401,6 +452,50 @@ void LinkedPriorityQueue<T,tgt>::delete_list(LN*& front) {
 }
 
 
+//Ties take from the first half, so values of equal priority keep their order in chain
+template<class T, bool (*tgt)(const T& a, const T& b)>
+auto LinkedPriorityQueue<T,tgt>::sort_chain(LN* chain, int n) -> LN* {
+  if (n <= 1) {
+    if (chain != nullptr)
+      chain->next = nullptr;
+    return chain;
+  }
+
+  int half = n/2;
+  LN* second = chain;
+  for (int i=0; i<half; ++i)
+    second = second->next;
+  LN* a = sort_chain(chain,half);   //Cuts the chain: its last LN's next becomes nullptr
+  LN* b = sort_chain(second,n-half);
+
+  LN  header;
+  LN* last = &header;
+  while (a != nullptr && b != nullptr)
+    if (gt(b->value,a->value)) {
+      last = last->next = b;
+      b = b->next;
+    }else{
+      last = last->next = a;
+      a = a->next;
+    }
+  last->next = (a != nullptr ? a : b);
+  return header.next;
+}
+
+
+//An existing value stays ahead of a new one only if it has higher priority (as in enqueue)
+template<class T, bool (*tgt)(const T& a, const T& b)>
+void LinkedPriorityQueue<T,tgt>::merge_chain(LN* chain) {
+  for (LN* p = front; chain != nullptr; p = p->next)
+    if (p->next == nullptr || !gt(p->next->value,chain->value)) {
+      LN* to_link = chain;
+      chain = chain->next;
+      to_link->next = p->next;
+      p->next = to_link;
+    }
+}
+
+
 
 
 
@@ -543,6 +638,49 @@ T* LinkedPriorityQueue<T,tgt>::Iterator::operator ->() const {
 }
 
 
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//FastIterator class definitions
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+LinkedPriorityQueue<T,tgt>::FastIterator::FastIterator(LN* initial)
+: current(initial) {
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+auto LinkedPriorityQueue<T,tgt>::FastIterator::operator ++ () -> LinkedPriorityQueue<T,tgt>::FastIterator& {
+  current = current->next;
+  return *this;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+bool LinkedPriorityQueue<T,tgt>::FastIterator::operator == (const LinkedPriorityQueue<T,tgt>::FastIterator& rhs) const {
+  return current == rhs.current;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+bool LinkedPriorityQueue<T,tgt>::FastIterator::operator != (const LinkedPriorityQueue<T,tgt>::FastIterator& rhs) const {
+  return current != rhs.current;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+T& LinkedPriorityQueue<T,tgt>::FastIterator::operator *() const {
+  return current->value;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+T* LinkedPriorityQueue<T,tgt>::FastIterator::operator ->() const {
+  return &(current->value);
+}
+
+
 }
 
 #endif /* LINKED_PRIORITY_QUEUE_HPP_ */
@@ -5,7 +5,9 @@
 #include <iostream>
 #include <sstream>
 #include <initializer_list>
+#include <utility>              //For std::move
 #include "ics_exceptions.hpp"
+#include "fast_range.hpp"
 
 
 namespace ics {
@@ -34,13 +36,19 @@ template<class T> class LinkedQueue {
 
     //Commands
     int  enqueue (const T& element);
+    int  enqueue (T&& element);
     T    dequeue ();
     void clear   ();
 
     //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
+    //The new LNs are built into a chain first, then linked onto rear at once
     template <class Iterable>
     int enqueue_all (const Iterable& i);
 
+    //Batch moves of LNs (no values are copied; no LNs are allocated/deallocated)
+    int splice_back (LinkedQueue<T>&& other);          //O(1): move all of other's values onto rear; other becomes empty
+    int dequeue_n   (int k, LinkedQueue<T>& out);      //O(k): move the first k (or all, if fewer) values onto out's rear
+
 
     //Operators
     LinkedQueue<T>& operator = (const LinkedQueue<T>& rhs);
@@ -92,12 +100,38 @@ template<class T> class LinkedQueue {
     Iterator end   () const;
 
 
+    //Unchecked iterator for hot loops: no mod_count/dynamic_cast checks and no erase.
+    //The queue must not be changed while one is in use; see ics::fast above for a "for-each" loop
+    class FastIterator {
+      public:
+        LinkedQueue<T>::FastIterator& operator ++ ();
+        bool operator == (const LinkedQueue<T>::FastIterator& rhs) const;
+        bool operator != (const LinkedQueue<T>::FastIterator& rhs) const;
+        T& operator *  () const;
+        T* operator -> () const;
+
+        friend FastIterator LinkedQueue<T>::fast_begin () const;
+        friend FastIterator LinkedQueue<T>::fast_end   () const;
+
+      private:
+        LN* current;
+
+        //Called in friends fast_begin/fast_end
+        FastIterator(LN* initial);
+    };
+
+
+    FastIterator fast_begin () const;
+    FastIterator fast_end   () const;
+
+
   private:
     class LN {
       public:
         LN ()                      {}
         LN (const LN& ln)          : value(ln.value), next(ln.next){}
-        LN (T v,  LN* n = nullptr) : value(v), next(n){}
+        LN (const T& v, LN* n = nullptr) : value(v), next(n){}
+        LN (T&& v,      LN* n = nullptr) : value(std::move(v)), next(n){}
 
         T   value;
         LN* next = nullptr;
@@ -111,6 +145,7 @@ template<class T> class LinkedQueue {
 
     //Helper methods
     void delete_list(LN*& front);  //Deallocate all LNs, and set front's argument to nullptr;
+    void link_chain (LN* first, LN* last, int count);  //Append the chain first..last (count LNs) onto rear
 };
 
 
@@ -135,24 +170,24 @@ LinkedQueue<T>::LinkedQueue() {
 
 
 template<class T>
-LinkedQueue<T>::LinkedQueue(const LinkedQueue<T>& to_copy) {
-  for (LN* p = to_copy.front; p != nullptr; p = p->next)
-    this->enqueue(p->value);
+LinkedQueue<T>::LinkedQueue(const LinkedQueue<T>& to_copy)
+: used(to_copy.used) {
+  LN** to = &front;
+  for (LN* p = to_copy.front; p != nullptr; p = p->next, to = &rear->next)
+    *to = rear = new LN(p->value);
 }
 
 
 template<class T>
 LinkedQueue<T>::LinkedQueue(const std::initializer_list<T>& il) {
-  for (T q_elem : il)
-    enqueue(q_elem);
+  enqueue_all(il);
 }
 
 
 template<class T>
 template<class Iterable>
 LinkedQueue<T>::LinkedQueue(const Iterable& i) {
-  for (auto v : i)
-    enqueue(v);
+  enqueue_all(i);
 }
 
 
@@ -213,6 +248,18 @@ int LinkedQueue<T>::enqueue(const T& element) {
 }
 
 
+template<class T>
+int LinkedQueue<T>::enqueue(T&& element) {
+  if (front == nullptr)
+    front = rear = new LN(std::move(element));
+  else
+    rear = rear->next = new LN(std::move(element));
+  ++used;
+  ++mod_count;
+  return 1;
+}
+
+
 template<class T>
 T LinkedQueue<T>::dequeue() {
   if (this->empty())
@@ -237,14 +284,61 @@ void LinkedQueue<T>::clear() {
 }
 
 
+//Iterating over *this is safe: it is not changed until the chain is linked
 template<class T>
 template<class Iterable>
 int LinkedQueue<T>::enqueue_all(const Iterable& i) {
-  int count = 0;
-  for (auto v : i)
-     count += enqueue(v);
+  LN*  first = nullptr;
+  LN*  last  = nullptr;
+  LN** to    = &first;
+  int  count = 0;
+  for (const T& v : i) {
+    *to = last = new LN(v);
+    to  = &last->next;
+    ++count;
+  }
+
+  if (count != 0)
+    link_chain(first,last,count);
+  return count;
+}
+
+
+template<class T>
+int LinkedQueue<T>::splice_back(LinkedQueue<T>&& other) {
+  if (this == &other || other.used == 0)
+    return 0;
+
+  int count = other.used;
+  link_chain(other.front,other.rear,count);
+  other.front = other.rear = nullptr;
+  other.used  = 0;
+  ++other.mod_count;
+  return count;
+}
+
 
-    return count;
+//Detach the chain first (so out may be *this: then the first k values move to the rear)
+template<class T>
+int LinkedQueue<T>::dequeue_n(int k, LinkedQueue<T>& out) {
+  if (k > used)
+    k = used;
+  if (k <= 0)
+    return 0;
+
+  LN* first = front;
+  LN* last  = front;
+  for (int i=1; i<k; ++i)
+    last = last->next;
+  front = last->next;
+  if (front == nullptr)
+    rear = nullptr;
+  last->next = nullptr;
+  used -= k;
+  ++mod_count;
+
+  out.link_chain(first,last,k);
+  return k;
 }
 
 
@@ -329,6 +423,18 @@ auto LinkedQueue<T>::end () const -> LinkedQueue<T>::Iterator {
 }
 
 
+template<class T>
+auto LinkedQueue<T>::fast_begin () const -> LinkedQueue<T>::FastIterator {
+  return FastIterator(front);
+}
+
+
+template<class T>
+auto LinkedQueue<T>::fast_end () const -> LinkedQueue<T>::FastIterator {
+  return FastIterator(nullptr);
+}
+
+
 ////////////////////////////////////////////////////////////////////////////////
 //
 //Private helper methods
@@ -345,6 +451,18 @@ void LinkedQueue<T>::delete_list(LN*& front) {
 }
 
 
+template<class T>
+void LinkedQueue<T>::link_chain(LN* first, LN* last, int count) {
+  if (front == nullptr)
+    front = first;
+  else
+    rear->next = first;
+  rear  = last;
+  used += count;
+  ++mod_count;
+}
+
+
 
 
 
@@ -501,6 +619,49 @@ T* LinkedQueue<T>::Iterator::operator ->() const {
 }
 
 
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//FastIterator class definitions
+
+template<class T>
+LinkedQueue<T>::FastIterator::FastIterator(LN* initial)
+: current(initial) {
+}
+
+
+template<class T>
+auto LinkedQueue<T>::FastIterator::operator ++ () -> LinkedQueue<T>::FastIterator& {
+  current = current->next;
+  return *this;
+}
+
+
+template<class T>
+bool LinkedQueue<T>::FastIterator::operator == (const LinkedQueue<T>::FastIterator& rhs) const {
+  return current == rhs.current;
+}
+
+
+template<class T>
+bool LinkedQueue<T>::FastIterator::operator != (const LinkedQueue<T>::FastIterator& rhs) const {
+  return current != rhs.current;
+}
+
+
+template<class T>
+T& LinkedQueue<T>::FastIterator::operator *() const {
+  return current->value;
+}
+
+
+template<class T>
+T* LinkedQueue<T>::FastIterator::operator ->() const {
+  return &(current->value);
+}
+
+
 }
 
 #endif /* LINKED_QUEUE_HPP_ */
@@ -5,31 +5,42 @@
 #include <iostream>
 #include <sstream>
 #include <initializer_list>
+#include <algorithm>            //For std::max
 #include "ics_exceptions.hpp"
+#include "hash_map.hpp"         //For the index (and undefinedhash)
+#include "fast_range.hpp"
 
 
 namespace ics {
 
 
+//contains (and so insert/erase) walks the list: O(N). If a constructor supplies chash, then once
+//  the set holds index_threshold values it builds an index (a HashMap from each value to its LN),
+//  and keeps it up to date, so contains/insert/erase are O(1) expected; below the threshold the
+//  list walk is cheaper than hashing. Without chash the set behaves as before (no index).
+//The copy constructor copies to_copy's hash function; operator = keeps this set's.
 template<class T> class LinkedSet {
   public:
+    typedef int (*hashfunc) (const T& a);
+
     //Destructor/Constructors
     ~LinkedSet();
 
-    LinkedSet          ();
+    LinkedSet          (int (*chash)(const T& a) = undefinedhash<T>);
     explicit LinkedSet (int initialLength);
     LinkedSet          (const LinkedSet<T>& to_copy);
-    explicit LinkedSet (const std::initializer_list<T>& il);
+    explicit LinkedSet (const std::initializer_list<T>& il, int (*chash)(const T& a) = undefinedhash<T>);
 
     //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
     template <class Iterable>
-    explicit LinkedSet (const Iterable& i);
+    explicit LinkedSet (const Iterable& i, int (*chash)(const T& a) = undefinedhash<T>);
 
 
     //Queries
     bool empty      () const;
     int  size       () const;
     bool contains   (const T& element) const;
+    bool indexed    () const; //true once the index is built (see above)
     std::string str () const; //supplies useful debugging information; contrast to operator <<
 
     //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
@@ -107,6 +118,31 @@ template<class T> class LinkedSet {
     Iterator end   () const;
 
 
+    //Unchecked iterator for hot loops: no mod_count/dynamic_cast checks and no erase.
+    //The set must not be changed while one is in use; see ics::fast above for a "for-each" loop
+    class FastIterator {
+      public:
+        LinkedSet<T>::FastIterator& operator ++ ();
+        bool operator == (const LinkedSet<T>::FastIterator& rhs) const;
+        bool operator != (const LinkedSet<T>::FastIterator& rhs) const;
+        T& operator *  () const;
+        T* operator -> () const;
+
+        friend FastIterator LinkedSet<T>::fast_begin () const;
+        friend FastIterator LinkedSet<T>::fast_end   () const;
+
+      private:
+        LN* current;
+
+        //Called in friends fast_begin/fast_end
+        FastIterator(LN* initial);
+    };
+
+
+    FastIterator fast_begin () const;
+    FastIterator fast_end   () const;
+
+
   private:
     class LN {
       public:
@@ -119,14 +155,21 @@ template<class T> class LinkedSet {
     };
 
 
+    static const int index_threshold = 32;  //Build the index when used reaches this (if hash is defined)
+
     LN* front     = new LN();
     LN* trailer   = front;         //Must always point to special trailer LN
     int used      =  0;            //Cache for number of values in linked list
     int mod_count = 0;             //For sensing concurrent modification
+    int (*hash)(const T& a) = undefinedhash<T>;  //Hashing function for the index (from constructor)
+    HashMap<T,LN*>* index = nullptr;             //value -> its LN; nullptr until built
 
     //Helper methods
-    int  erase_at   (LN* p);
-    void delete_list(LN*& front);  //Deallocate all LNs (but trailer), and set front's argument to trailer;
+    LN*  find_element (const T& element) const;  //Returns element's LN (by index or list walk) or nullptr
+    void ensure_index ();          //Build the index if hash is defined and used >= index_threshold
+    void drop_index   ();          //Deallocate the index (if any)
+    int  erase_at     (LN* p);
+    void delete_list  (LN*& front);  //Deallocate all LNs (but trailer), and set front's argument to trailer;
 };
 
 
@@ -141,27 +184,29 @@ template<class T> class LinkedSet {
 
 template<class T>
 LinkedSet<T>::~LinkedSet() {
+  drop_index();
   delete_list(front);
   delete trailer;
 }
 
 
 template<class T>
-LinkedSet<T>::LinkedSet() {
+LinkedSet<T>::LinkedSet(int (*chash)(const T& a)) : hash(chash) {
 }
 
 
 template<class T>
-LinkedSet<T>::LinkedSet(const LinkedSet<T>& to_copy) : used(to_copy.used) {
+LinkedSet<T>::LinkedSet(const LinkedSet<T>& to_copy) : used(to_copy.used), hash(to_copy.hash) {
   for (LN* f = to_copy.front; f != to_copy.trailer; f = f->next)
     front = new LN(f->value,front);
   //efficiency: use reverse order, since order in a set is unimportant
   //because to_copy is a set, we know all values are unique
+  ensure_index();
 }
 
 
 template<class T>
-LinkedSet<T>::LinkedSet(const std::initializer_list<T>& il) {
+LinkedSet<T>::LinkedSet(const std::initializer_list<T>& il, int (*chash)(const T& a)) : hash(chash) {
   for (T s_elem : il)
     insert(s_elem);
 }
@@ -169,7 +214,7 @@ LinkedSet<T>::LinkedSet(const std::initializer_list<T>& il) {
 
 template<class T>
 template<class Iterable>
-LinkedSet<T>::LinkedSet(const Iterable& i) {
+LinkedSet<T>::LinkedSet(const Iterable& i, int (*chash)(const T& a)) : hash(chash) {
   for (auto v : i)
     insert(v);
 }
@@ -193,11 +238,13 @@ int LinkedSet<T>::size() const {
 
 template<class T>
 bool LinkedSet<T>::contains (const T& element) const {
-  for (LN* p = front; p != trailer; p=p->next)
-    if (p->value == element)
-      return true;
+  return find_element(element) != nullptr;
+}
+
 
-  return false;
+template<class T>
+bool LinkedSet<T>::indexed () const {
+  return index != nullptr;
 }
 
 
@@ -212,7 +259,7 @@ std::string LinkedSet<T>::str() const {
       answer << "->" << p->value;
   }
 
-  answer << "->TRAILER](used=" << used << ",front=" << front << ",trailer=" << trailer << ",mod_count=" << mod_count << ")";
+  answer << "->TRAILER](used=" << used << ",front=" << front << ",trailer=" << trailer << ",mod_count=" << mod_count << ",indexed=" << indexed() << ")";
   return answer.str();
 }
 
@@ -241,22 +288,24 @@ int LinkedSet<T>::insert(const T& element) {
   front = new LN(element,front);
   ++used;
   ++mod_count;
+  if (index != nullptr)
+    index->put(element,front);
+  else
+    ensure_index();
   return 1;
 }
 
 
 template<class T>
 int LinkedSet<T>::erase(const T& element) {
-  for (LN* p = front; p != trailer; p=p->next)
-    if (p->value == element)
-      return erase_at(p);
-
-  return 0;
+  LN* p = find_element(element);
+  return p == nullptr ? 0 : erase_at(p);
 }
 
 
 template<class T>
 void LinkedSet<T>::clear() {
+  drop_index();
   delete_list(front);
   used = 0;
   ++mod_count;
@@ -288,7 +337,7 @@ int LinkedSet<T>::erase_all(const Iterable& i) {
 template<class T>
 template<class Iterable>
 int LinkedSet<T>::retain_all(const Iterable& i) {
-  LinkedSet s(i);
+  LinkedSet s(i,hash);
   int count = 0;
   for (LN* p = front; p != trailer; /*see body*/)
     if (!s.contains(p->value)) {
@@ -324,6 +373,8 @@ LinkedSet<T>& LinkedSet<T>::operator = (const LinkedSet<T>& rhs) {
   if (*to != trailer)
     delete_list(*to);
 
+  drop_index();                    //The values in the reused LNs changed: rebuild
+  ensure_index();
   ++mod_count;
   return *this;
 }
@@ -420,16 +471,65 @@ auto LinkedSet<T>::end () const -> LinkedSet<T>::Iterator {
 }
 
 
+template<class T>
+auto LinkedSet<T>::fast_begin () const -> LinkedSet<T>::FastIterator {
+  return FastIterator(front);
+}
+
+
+template<class T>
+auto LinkedSet<T>::fast_end () const -> LinkedSet<T>::FastIterator {
+  return FastIterator(trailer);
+}
+
+
 ////////////////////////////////////////////////////////////////////////////////
 //
 //Private helper methods
 
+template<class T>
+auto LinkedSet<T>::find_element(const T& element) const -> LN* {
+  if (index != nullptr)
+    return index->has_key(element) ? (*index)[element] : nullptr;
+
+  for (LN* p = front; p != trailer; p=p->next)
+    if (p->value == element)
+      return p;
+
+  return nullptr;
+}
+
+
+template<class T>
+void LinkedSet<T>::ensure_index() {
+  if (index != nullptr || hash == (hashfunc)undefinedhash<T> || used < index_threshold)
+    return;
+
+  index = new HashMap<T,LN*>(std::max(1,used), 1.0, hash);
+  for (LN* p = front; p != trailer; p=p->next)
+    index->put(p->value,p);
+}
+
+
+template<class T>
+void LinkedSet<T>::drop_index() {
+  delete index;
+  index = nullptr;
+}
+
+
+//p's LN is kept: it receives the next LN's value/next (and that LN is deleted), so the index
+//  must forget p's value and map the moved value to p
 template<class T>
 int LinkedSet<T>::erase_at(LN* p) {
   LN* to_delete = p->next;
+  if (index != nullptr)
+    index->erase(p->value);
   if (p->next == trailer)
     trailer = p;
   *p = *(p->next);
+  if (index != nullptr && p != trailer)
+    index->put(p->value,p);
   delete to_delete;
   --used;
   ++mod_count;
@@ -584,6 +684,49 @@ T* LinkedSet<T>::Iterator::operator ->() const {
 }
 
 
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//FastIterator class definitions
+
+template<class T>
+LinkedSet<T>::FastIterator::FastIterator(LN* initial)
+: current(initial) {
+}
+
+
+template<class T>
+auto LinkedSet<T>::FastIterator::operator ++ () -> LinkedSet<T>::FastIterator& {
+  current = current->next;
+  return *this;
+}
+
+
+template<class T>
+bool LinkedSet<T>::FastIterator::operator == (const LinkedSet<T>::FastIterator& rhs) const {
+  return current == rhs.current;
+}
+
+
+template<class T>
+bool LinkedSet<T>::FastIterator::operator != (const LinkedSet<T>::FastIterator& rhs) const {
+  return current != rhs.current;
+}
+
+
+template<class T>
+T& LinkedSet<T>::FastIterator::operator *() const {
+  return current->value;
+}
+
+
+template<class T>
+T* LinkedSet<T>::FastIterator::operator ->() const {
+  return &(current->value);
+}
+
+
 }
 
 #endif /* LINKED_SET_HPP_ */
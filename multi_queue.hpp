@@ -0,0 +1,294 @@
+#ifndef MULTI_QUEUE_HPP_
+#define MULTI_QUEUE_HPP_
+
+#include <string>
+#include <iostream>
+#include <sstream>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+#include "ics_exceptions.hpp"
+#include "heap_priority_queue.hpp"
+
+
+namespace ics {
+
+
+//A concurrent, relaxed priority queue (a MultiQueue): values live in queues HeapPriorityQueue
+//  sub-heaps, each with its own lock. enqueue puts a value into a random sub-heap; dequeue samples
+//  choices random sub-heaps and removes the highest of their tops. So dequeue returns a value of
+//  high (but not necessarily the highest) priority; with 2 choices the expected rank error is
+//  O(queues). choices >= queues locks every sub-heap for each dequeue: exact, but serial.
+//Use 2-4 sub-heaps per thread. All methods may be called concurrently; size/empty are approximate
+//  while other threads are enqueueing/dequeueing.
+//
+//Instantiate the templated class supplying tgt(a,b): true, iff a has higher priority than b.
+//If tgt is defaulted to undefinedgt in the template, then a constructor must supply cgt.
+//If both tgt and cgt are supplied, then they must be the same (by ==) function.
+//If neither is supplied, or both are supplied but different, TemplateFunctionError is raised.
+template<class T, bool (*tgt)(const T& a, const T& b) = undefinedgt<T>> class MultiQueue {
+  public:
+    typedef bool (*gtfunc) (const T& a, const T& b);
+
+    //Destructor/Constructors
+    ~MultiQueue();
+
+    explicit MultiQueue(int queues, int choices = 2, bool (*cgt)(const T& a, const T& b) = undefinedgt<T>);
+    MultiQueue(const MultiQueue<T,tgt>& to_copy) = delete;
+
+
+    //Queries
+    bool empty      () const;
+    int  size       () const;
+    std::string str () const; //supplies useful debugging information; locks each sub-heap in turn
+
+
+    //Commands
+    int  enqueue     (const T& element);
+    T    dequeue     ();               //throws EmptyError if every sub-heap is empty
+    bool try_dequeue (T& answer);      //false (and answer unchanged) if every sub-heap is empty
+    void clear       ();
+
+    //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
+    template <class Iterable>
+    int enqueue_all (const Iterable& i);
+
+
+    //Operators
+    MultiQueue<T,tgt>& operator = (const MultiQueue<T,tgt>& rhs) = delete;
+
+    template<class T2, bool (*gt2)(const T2& a, const T2& b)>
+    friend std::ostream& operator << (std::ostream& outs, const MultiQueue<T2,gt2>& mq);
+
+
+  private:
+    static const int cache_line = 64;
+
+    class alignas(cache_line) SubHeap {   //Own cache line(s), so locking one does not slow another
+      public:
+        SubHeap(gtfunc gt) : heap(gt) {}
+
+        std::mutex                lock;
+        HeapPriorityQueue<T,tgt>  heap;
+    };
+
+    gtfunc            gt;                 // The gt used by the sub-heaps (from template or constructor)
+    SubHeap**         sub;                // sub[0..queues): the sub-heaps
+    int               queues;
+    int               choices;            // # sub-heaps sampled per dequeue
+    std::atomic<int>  used;               // Approximate # values in all sub-heaps
+
+
+    //Helper methods
+    static unsigned random (unsigned bound);       //Uniform in [0,bound): per-thread xorshift
+    bool dequeue_sampled   (T& answer);            //Relaxed: best of choices try_locked sub-heaps
+    bool dequeue_exact     (T& answer);            //Strict: best of all sub-heaps (locked in order)
+};
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//MultiQueue class and related definitions
+
+//Destructor/Constructors
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+MultiQueue<T,tgt>::~MultiQueue() {
+  for (int q=0; q<queues; ++q)
+    delete sub[q];
+  delete[] sub;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+MultiQueue<T,tgt>::MultiQueue(int queues, int choices, bool (*cgt)(const T& a, const T& b))
+: gt(tgt != (gtfunc)undefinedgt<T> ? tgt : cgt), queues(queues < 1 ? 1 : queues),
+  choices(choices < 1 ? 1 : choices), used(0) {
+  if (gt == (gtfunc)undefinedgt<T>)
+    throw TemplateFunctionError("MultiQueue::constructor: neither specified");
+  if (tgt != (gtfunc)undefinedgt<T> && cgt != (gtfunc)undefinedgt<T> && tgt != cgt)
+    throw TemplateFunctionError("MultiQueue::constructor: both specified and different");
+
+  sub = new SubHeap*[this->queues];
+  for (int q=0; q<this->queues; ++q)
+    sub[q] = new SubHeap(gt);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Queries
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+bool MultiQueue<T,tgt>::empty() const {
+  return used.load() <= 0;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+int MultiQueue<T,tgt>::size() const {
+  int answer = used.load();
+  return answer < 0 ? 0 : answer;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+std::string MultiQueue<T,tgt>::str() const {
+  std::ostringstream answer;
+  answer << "MultiQueue[";
+  for (int q=0; q<queues; ++q) {
+    std::lock_guard<std::mutex> guard(sub[q]->lock);
+    answer << (q == 0 ? "" : ",") << q << ":" << sub[q]->heap.str();
+  }
+  answer << "](queues=" << queues << ",choices=" << choices << ",used=" << used.load() << ")";
+  return answer.str();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Commands
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+int MultiQueue<T,tgt>::enqueue(const T& element) {
+  //try_lock random sub-heaps: a busy one is skipped rather than waited for
+  for (;;) {
+    SubHeap* s = sub[random(queues)];
+    if (s->lock.try_lock()) {
+      s->heap.enqueue(element);
+      s->lock.unlock();
+      ++used;
+      return 1;
+    }
+  }
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+T MultiQueue<T,tgt>::dequeue() {
+  T answer;
+  if (!try_dequeue(answer))
+    throw EmptyError("MultiQueue::dequeue");
+
+  return answer;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+bool MultiQueue<T,tgt>::try_dequeue(T& answer) {
+  if (choices < queues)
+    for (int tries = 0; tries < queues && used.load() > 0; ++tries)
+      if (dequeue_sampled(answer))
+        return true;
+
+  //Exact (or, if sampling kept finding empty sub-heaps, make sure every one is empty)
+  return dequeue_exact(answer);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+void MultiQueue<T,tgt>::clear() {
+  for (int q=0; q<queues; ++q) {
+    std::lock_guard<std::mutex> guard(sub[q]->lock);
+    used -= sub[q]->heap.size();
+    sub[q]->heap.clear();
+  }
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+template <class Iterable>
+int MultiQueue<T,tgt>::enqueue_all (const Iterable& i) {
+  int count = 0;
+  for (const T& v : i)
+     count += enqueue(v);
+
+  return count;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Operators
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+std::ostream& operator << (std::ostream& outs, const MultiQueue<T,tgt>& mq) {
+  outs << "multi_queue[";
+  for (int q=0; q<mq.queues; ++q) {
+    std::lock_guard<std::mutex> guard(mq.sub[q]->lock);
+    outs << (q == 0 ? "" : ",") << mq.sub[q]->heap;
+  }
+
+  outs << "]";
+  return outs;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Private helper methods
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+unsigned MultiQueue<T,tgt>::random(unsigned bound) {
+  static thread_local std::uint32_t state = 0;
+  if (state == 0)   //Seed each thread differently (xorshift state must be non-0)
+    state = std::uint32_t(reinterpret_cast<std::uintptr_t>(&state) >> 4) | 1;
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return state % bound;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+bool MultiQueue<T,tgt>::dequeue_sampled(T& answer) {
+  //Sample choices sub-heaps; keep the one whose top has the highest priority locked, and
+  //  unlock all the others (and any that are empty) as soon as they lose
+  SubHeap* best = nullptr;
+  for (int c=0; c<choices; ++c) {
+    SubHeap* s = sub[random(queues)];
+    if (s == best || !s->lock.try_lock())
+      continue;
+    if (!s->heap.empty() && (best == nullptr || gt(s->heap.peek(),best->heap.peek()))) {
+      if (best != nullptr)
+        best->lock.unlock();
+      best = s;
+    }else
+      s->lock.unlock();
+  }
+
+  if (best == nullptr)
+    return false;
+  answer = best->heap.dequeue();
+  best->lock.unlock();
+  --used;
+  return true;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+bool MultiQueue<T,tgt>::dequeue_exact(T& answer) {
+  //Locking in index order cannot deadlock with another dequeue_exact; enqueue only try_locks
+  for (int q=0; q<queues; ++q)
+    sub[q]->lock.lock();
+
+  SubHeap* best = nullptr;
+  for (int q=0; q<queues; ++q)
+    if (!sub[q]->heap.empty() && (best == nullptr || gt(sub[q]->heap.peek(),best->heap.peek())))
+      best = sub[q];
+  if (best != nullptr) {
+    answer = best->heap.dequeue();
+    --used;
+  }
+
+  for (int q=0; q<queues; ++q)
+    sub[q]->lock.unlock();
+  return best != nullptr;
+}
+
+}
+
+#endif /* MULTI_QUEUE_HPP_ */
@@ -0,0 +1,708 @@
+#ifndef PAIRING_HEAP_PRIORITY_QUEUE_HPP_
+#define PAIRING_HEAP_PRIORITY_QUEUE_HPP_
+
+#include <string>
+#include <iostream>
+#include <sstream>
+#include <initializer_list>
+#include "ics_exceptions.hpp"
+#include <utility>              //For std::swap/std::move
+#include "array_stack.hpp"      //See operator << and tree walks
+#include "priority_queue_equal.hpp"
+
+
+namespace ics {
+
+
+#ifndef undefinedgtdefined
+#define undefinedgtdefined
+template<class T>
+bool undefinedgt (const T& a, const T& b) {return false;}
+#endif /* undefinedgtdefined */
+
+//A meldable, addressable heap (a pairing heap): meld moves every value of another queue into
+//  this one in O(1); enqueue is O(1); dequeue is amortized O(log N) (two-pass pairing); update
+//  to a value of higher (or equal) priority -- decrease_key -- is O(1), and to a value of lower
+//  priority or erase is amortized O(log N).
+//enqueue returns a Handle that names its value until that value is dequeued or erased (a melded
+//  value keeps its Handle, which then names it in the queue it was melded into).
+//Handles are checked, as in IndexedHeapPriorityQueue: update/erase/operator [] throw KeyError
+//  for a Handle whose value was removed, or that names a value in another queue. So nodes are not
+//  deleted one by one: they come from a NodePool of blocks that lives as long as the queue, and
+//  are recycled with a new generation. meld moves other's pool into this queue's (in O(1)); a
+//  node's owning queue is found by following the pools' merged_into links (as in union-find).
+//
+//Instantiate the templated class supplying tgt(a,b): true, iff a has higher priority than b.
+//If tgt is defaulted to undefinedgt in the template, then a constructor must supply cgt.
+//If both tgt and cgt are supplied, then they must be the same (by ==) function.
+//If neither is supplied, or both are supplied but different, TemplateFunctionError is raised.
+//The (unique) non-undefinedgt value supplied by tgt/cgt is stored in the instance variable gt.
+template<class T, bool (*tgt)(const T& a, const T& b) = undefinedgt<T>> class PairingHeapPriorityQueue {
+  private:
+    class PN;
+
+  public:
+    typedef bool (*gtfunc) (const T& a, const T& b);
+
+    class Handle {
+      public:
+        Handle() {}                       //Names no value
+        bool operator == (const Handle& rhs) const {return node == rhs.node && generation == rhs.generation;}
+        bool operator != (const Handle& rhs) const {return !(*this == rhs);}
+      private:
+        Handle(PN* node, int generation) : node(node), generation(generation) {}
+        PN* node       = nullptr;
+        int generation = 0;
+        friend class PairingHeapPriorityQueue<T,tgt>;
+    };
+
+    //Destructor/Constructors
+    ~PairingHeapPriorityQueue();
+
+    PairingHeapPriorityQueue(bool (*cgt)(const T& a, const T& b) = undefinedgt<T>);
+    PairingHeapPriorityQueue(const PairingHeapPriorityQueue<T,tgt>& to_copy, bool (*cgt)(const T& a, const T& b) = undefinedgt<T>);
+    explicit PairingHeapPriorityQueue(const std::initializer_list<T>& il, bool (*cgt)(const T& a, const T& b) = undefinedgt<T>);
+
+    //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
+    template <class Iterable>
+    explicit PairingHeapPriorityQueue (const Iterable& i, bool (*cgt)(const T& a, const T& b) = undefinedgt<T>);
+
+
+    //Queries
+    bool empty       () const;
+    int  size        () const;
+    bool contains    (Handle h) const;
+    const T& peek    () const;
+    Handle peek_handle () const;   //handle of the value peek returns
+    std::string str  () const; //supplies useful debugging information; contrast to operator <<
+
+
+    //Commands
+    Handle enqueue (const T& element);                 //returns the handle naming element
+    T      dequeue ();
+    T      update  (Handle h, const T& new_value);     //returns old value; O(1) if priority does not fall
+    T      erase   (Handle h);
+    int    meld    (PairingHeapPriorityQueue<T,tgt>& other);  //moves all of other's values here; returns #
+    void   clear   ();
+
+    //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
+    template <class Iterable>
+    int enqueue_all (const Iterable& i);
+
+
+    //Operators
+    const T& operator [] (Handle h) const;  //No T& version: changing a value must go through update
+    PairingHeapPriorityQueue<T,tgt>& operator = (const PairingHeapPriorityQueue<T,tgt>& rhs);
+    bool operator == (const PairingHeapPriorityQueue<T,tgt>& rhs) const;
+    bool operator != (const PairingHeapPriorityQueue<T,tgt>& rhs) const;
+
+    template<class T2, bool (*gt2)(const T2& a, const T2& b)>
+    friend std::ostream& operator << (std::ostream& outs, const PairingHeapPriorityQueue<T2,gt2>& pq);
+
+
+  private:
+    class NodePool;
+
+    //A node's children are its child and that child's sibling chain; prev is the node's left
+    //  sibling, or its parent if it is the leftmost child (nullptr for the root)
+    class PN {
+      public:
+        PN ()                   : value()      {}
+
+        T         value;
+        PN*       child      = nullptr;
+        PN*       sibling    = nullptr;   //Also links a pool's free nodes
+        PN*       prev       = nullptr;
+        NodePool* pool       = nullptr;   //The pool whose block holds this node
+        int       generation = 0;         //Incremented each time the node is freed
+    };
+
+    //Blocks of nodes, and the free ones among them. A pool melded into another is kept (and
+    //  deleted) by it: absorbed/next_absorbed form a tree of pools; merged_into points up it
+    class NodePool {
+      public:
+        ~NodePool() {while (!blocks.empty()) delete[] blocks.pop();}
+
+        ArrayStack<PN*> blocks;
+        PN*       free          = nullptr;   //Free nodes, linked through sibling
+        PN*       free_tail     = nullptr;
+        PN*       fresh         = nullptr;   //Next never-used node in the newest block
+        int       fresh_left    = 0;
+        int       next_length   = 16;        //Length of the next block allocated
+        NodePool* merged_into   = nullptr;
+        NodePool* absorbed      = nullptr;
+        NodePool* next_absorbed = nullptr;
+    };
+
+    bool (*gt) (const T& a, const T& b); // The gt used by enqueue (from template or constructor)
+    PN*       root      = nullptr;
+    NodePool* pool      = nullptr;       //Created by the first enqueue (or taken over by meld)
+    int       used      = 0;             //# of values (nodes) in the heap
+    int       mod_count = 0;             //For sensing concurrent modification
+
+
+    //Helper methods
+    PN*  link             (PN* a, PN* b);  //Roots a/b: the lower becomes the leftmost child of the higher
+    PN*  combine_siblings (PN* first);     //Two-pass pairing of first's sibling chain; returns one root
+    void cut              (PN* n);         //Detach the subtree rooted at n from its parent/siblings
+    void copy_values      (const PairingHeapPriorityQueue<T,tgt>& from);
+    void value_pointers   (const T** answer) const;   //Store a pointer to each value in answer[0..used)
+    PN*  new_node         (const T& v);
+    void free_node        (PN* n);         //Return n to pool with a new generation
+    void free_nodes       (PN* n);         //Free n, its siblings, and all their descendants
+    bool owns             (PN* n) const;   //n's pool is (now merged into) this queue's pool
+    void check_handle     (Handle h, const char* where) const;  //KeyError if !contains(h)
+    static void delete_pools (NodePool* p);  //Delete p and every pool absorbed into it
+};
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//PairingHeapPriorityQueue class and related definitions
+
+//Destructor/Constructors
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+PairingHeapPriorityQueue<T,tgt>::~PairingHeapPriorityQueue() {
+  delete_pools(pool);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+PairingHeapPriorityQueue<T,tgt>::PairingHeapPriorityQueue(bool (*cgt)(const T& a, const T& b))
+: gt(tgt != (gtfunc)undefinedgt<T> ? tgt : cgt) {
+  if (gt == (gtfunc)undefinedgt<T>)
+    throw TemplateFunctionError("PairingHeapPriorityQueue::default constructor: neither specified");
+  if (tgt != (gtfunc)undefinedgt<T> && cgt != (gtfunc)undefinedgt<T> && tgt != cgt)
+    throw TemplateFunctionError("PairingHeapPriorityQueue::default constructor: both specified and different");
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+PairingHeapPriorityQueue<T,tgt>::PairingHeapPriorityQueue(const PairingHeapPriorityQueue<T,tgt>& to_copy, bool (*cgt)(const T& a, const T& b))
+: gt(tgt != (gtfunc)undefinedgt<T> ? tgt : cgt) {
+  if (gt == (gtfunc)undefinedgt<T>)
+    gt = to_copy.gt;//throw TemplateFunctionError("PairingHeapPriorityQueue::copy constructor: neither specified");
+  if (tgt != (gtfunc)undefinedgt<T> && cgt != (gtfunc)undefinedgt<T> && tgt != cgt)
+    throw TemplateFunctionError("PairingHeapPriorityQueue::copy constructor: both specified and different");
+
+  copy_values(to_copy);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+PairingHeapPriorityQueue<T,tgt>::PairingHeapPriorityQueue(const std::initializer_list<T>& il, bool (*cgt)(const T& a, const T& b))
+: gt(tgt != (gtfunc)undefinedgt<T> ? tgt : cgt) {
+  if (gt == (gtfunc)undefinedgt<T>)
+    throw TemplateFunctionError("PairingHeapPriorityQueue::initializer_list constructor: neither specified");
+  if (tgt != (gtfunc)undefinedgt<T> && cgt != (gtfunc)undefinedgt<T> && tgt != cgt)
+    throw TemplateFunctionError("PairingHeapPriorityQueue::initializer_list constructor: both specified and different");
+
+  for (const T& pq_elem : il)
+    enqueue(pq_elem);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+template<class Iterable>
+PairingHeapPriorityQueue<T,tgt>::PairingHeapPriorityQueue(const Iterable& i, bool (*cgt)(const T& a, const T& b))
+: gt(tgt != (gtfunc)undefinedgt<T> ? tgt : cgt) {
+  if (gt == (gtfunc)undefinedgt<T>)
+    throw TemplateFunctionError("PairingHeapPriorityQueue::Iterable constructor: neither specified");
+  if (tgt != (gtfunc)undefinedgt<T> && cgt != (gtfunc)undefinedgt<T> && tgt != cgt)
+    throw TemplateFunctionError("PairingHeapPriorityQueue::Iterable constructor: both specified and different");
+
+  for (const T& pq_elem : i)
+    enqueue(pq_elem);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Queries
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+bool PairingHeapPriorityQueue<T,tgt>::empty() const {
+  return used == 0;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+int PairingHeapPriorityQueue<T,tgt>::size() const {
+  return used;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+bool PairingHeapPriorityQueue<T,tgt>::contains(Handle h) const {
+  return h.node != nullptr && owns(h.node) && h.node->generation == h.generation;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+const T& PairingHeapPriorityQueue<T,tgt>::peek () const {
+  if (empty())
+    throw EmptyError("PairingHeapPriorityQueue::peek");
+
+  return root->value;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+auto PairingHeapPriorityQueue<T,tgt>::peek_handle () const -> Handle {
+  if (empty())
+    throw EmptyError("PairingHeapPriorityQueue::peek_handle");
+
+  return Handle(root,root->generation);
+}
+
+
+//Values in preorder; a value's children follow it in ()
+template<class T, bool (*tgt)(const T& a, const T& b)>
+std::string PairingHeapPriorityQueue<T,tgt>::str() const {
+  std::ostringstream answer;
+  answer << "PairingHeapPriorityQueue[";
+
+  ArrayStack<PN*> st;   //Siblings of the nodes whose children are being shown
+  for (PN* p = root; ; ) {
+    if (p == nullptr) {
+      if (st.empty())
+        break;
+      answer << ")";
+      p = st.pop();
+      if (p != nullptr)
+        answer << ",";
+    }else if (p->child != nullptr) {
+      answer << p->value << "(";
+      st.push(p->sibling);
+      p = p->child;
+    }else{
+      answer << p->value;
+      p = p->sibling;
+      if (p != nullptr)
+        answer << ",";
+    }
+  }
+
+  answer << "](used=" << used << ",mod_count=" << mod_count << ")";
+  return answer.str();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Commands
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+auto PairingHeapPriorityQueue<T,tgt>::enqueue(const T& element) -> Handle {
+  PN* n = new_node(element);
+  root = (root == nullptr ? n : link(root,n));
+  ++used;
+  ++mod_count;
+  return Handle(n,n->generation);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+T PairingHeapPriorityQueue<T,tgt>::dequeue() {
+  if (this->empty())
+    throw EmptyError("PairingHeapPriorityQueue::dequeue");
+
+  PN* to_free = root;
+  T to_return = std::move(root->value);
+  root = combine_siblings(root->child);
+  free_node(to_free);
+  --used;
+  ++mod_count;
+  return to_return;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+T PairingHeapPriorityQueue<T,tgt>::update(Handle h, const T& new_value) {
+  check_handle(h,"update");
+  PN* n = h.node;
+
+  T to_return = n->value;
+  n->value = new_value;
+  bool fell = gt(to_return,new_value);
+  if (n == root) {
+    //Still highest unless its priority fell: then it must compete with its children
+    if (fell && n->child != nullptr) {
+      PN* children = combine_siblings(n->child);
+      n->child = nullptr;
+      root = link(n,children);
+    }
+  }else if (!fell) {
+    //decrease_key: the subtree stays heap-ordered, so cut it and link it to the root
+    cut(n);
+    root = link(root,n);
+  }else{
+    //Lower priority: cut n out alone; its children (paired) and n rejoin at the root
+    cut(n);
+    PN* children = combine_siblings(n->child);
+    n->child = nullptr;
+    root = link(root,n);
+    if (children != nullptr)
+      root = link(root,children);
+  }
+
+  ++mod_count;
+  return to_return;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+T PairingHeapPriorityQueue<T,tgt>::erase(Handle h) {
+  check_handle(h,"erase");
+  PN* n = h.node;
+  if (n == root)
+    return dequeue();
+
+  cut(n);
+  PN* children = combine_siblings(n->child);
+  if (children != nullptr)
+    root = link(root,children);
+
+  T to_return = std::move(n->value);
+  free_node(n);
+  --used;
+  ++mod_count;
+  return to_return;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+int PairingHeapPriorityQueue<T,tgt>::meld(PairingHeapPriorityQueue<T,tgt>& other) {
+  if (this == &other || other.empty())
+    return 0;
+  if (gt != other.gt)
+    throw TemplateFunctionError("PairingHeapPriorityQueue::meld: different gt functions");
+
+  //Take over other's pool (and its free nodes): its nodes, and their Handles, now belong here
+  NodePool* o = other.pool;
+  if (pool == nullptr)
+    pool = o;
+  else {
+    o->merged_into   = pool;
+    o->next_absorbed = pool->absorbed;
+    pool->absorbed   = o;
+    if (o->free != nullptr) {
+      o->free_tail->sibling = pool->free;
+      if (pool->free == nullptr)
+        pool->free_tail = o->free_tail;
+      pool->free = o->free;
+      o->free = o->free_tail = nullptr;
+    }
+  }
+
+  int moved = other.used;
+  root = (root == nullptr ? other.root : link(root,other.root));
+  used += moved;
+  other.root = nullptr;
+  other.pool = nullptr;
+  other.used = 0;
+  ++mod_count;
+  ++other.mod_count;
+  return moved;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+void PairingHeapPriorityQueue<T,tgt>::clear() {
+  free_nodes(root);
+  root = nullptr;
+  used = 0;
+  ++mod_count;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+template <class Iterable>
+int PairingHeapPriorityQueue<T,tgt>::enqueue_all (const Iterable& i) {
+  int count = 0;
+  for (const T& v : i) {
+    enqueue(v);
+    ++count;
+  }
+
+  return count;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Operators
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+const T& PairingHeapPriorityQueue<T,tgt>::operator [] (Handle h) const {
+  check_handle(h,"operator []");
+  return h.node->value;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+PairingHeapPriorityQueue<T,tgt>& PairingHeapPriorityQueue<T,tgt>::operator = (const PairingHeapPriorityQueue<T,tgt>& rhs) {
+  if (this == &rhs)
+    return *this;
+
+  gt = rhs.gt;   // if tgt != nullptr, gts are already equal (or compiler error)
+  clear();
+  copy_values(rhs);
+  return *this;
+}
+
+
+//Equal if same gt and the same values (see priority_queue_equal); handles are not compared
+template<class T, bool (*tgt)(const T& a, const T& b)>
+bool PairingHeapPriorityQueue<T,tgt>::operator == (const PairingHeapPriorityQueue<T,tgt>& rhs) const {
+  if (this == &rhs)
+    return true;
+  if (gt != rhs.gt) //For PriorityQueues to be equal, they need the same gt function, and values
+    return false;
+  if (used != rhs.size())
+    return false;
+
+  const T** l = new const T*[used];
+  const T** r = new const T*[used];
+  this->value_pointers(l);
+  rhs.value_pointers(r);
+  bool answer = priority_queue_equal(l,r,used,gt);
+
+  delete[] l;
+  delete[] r;
+  return answer;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+bool PairingHeapPriorityQueue<T,tgt>::operator != (const PairingHeapPriorityQueue<T,tgt>& rhs) const {
+  return !(*this == rhs);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+std::ostream& operator << (std::ostream& outs, const PairingHeapPriorityQueue<T,tgt>& p) {
+  outs << "priority_queue[";
+
+  if (!p.empty()) {
+    PairingHeapPriorityQueue<T,tgt> temp(p);
+    ArrayStack<T> st;
+    while (!temp.empty())
+      st.push(temp.dequeue());
+    outs << st.pop();
+    while (!st.empty())
+      outs << "," << st.pop();
+  }
+
+  outs << "]:highest";
+  return outs;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Private helper methods
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+auto PairingHeapPriorityQueue<T,tgt>::link(PN* a, PN* b) -> PN* {
+  if (gt(b->value,a->value))
+    std::swap(a,b);
+
+  b->sibling = a->child;
+  if (a->child != nullptr)
+    a->child->prev = b;
+  b->prev    = a;
+  a->child   = b;
+  a->sibling = a->prev = nullptr;
+  return a;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+auto PairingHeapPriorityQueue<T,tgt>::combine_siblings(PN* first) -> PN* {
+  if (first == nullptr)
+    return nullptr;
+
+  //Pass 1: link pairs left to right, stacking the results through their sibling fields
+  PN* pairs = nullptr;
+  while (first != nullptr) {
+    PN* a = first;
+    PN* b = a->sibling;
+    if (b == nullptr) {
+      a->sibling = pairs;
+      pairs = a;
+      break;
+    }
+    first = b->sibling;
+    PN* l = link(a,b);
+    l->sibling = pairs;
+    pairs = l;
+  }
+
+  //Pass 2: link the results right to left (the stack pops them in that order)
+  PN* answer = pairs;
+  pairs = pairs->sibling;
+  while (pairs != nullptr) {
+    PN* next = pairs->sibling;
+    answer = link(pairs,answer);
+    pairs = next;
+  }
+
+  answer->sibling = answer->prev = nullptr;
+  return answer;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+void PairingHeapPriorityQueue<T,tgt>::cut(PN* n) {
+  if (n->prev->child == n)
+    n->prev->child = n->sibling;
+  else
+    n->prev->sibling = n->sibling;
+  if (n->sibling != nullptr)
+    n->sibling->prev = n->prev;
+  n->sibling = n->prev = nullptr;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+void PairingHeapPriorityQueue<T,tgt>::copy_values(const PairingHeapPriorityQueue<T,tgt>& from) {
+  if (from.root == nullptr)
+    return;
+
+  ArrayStack<PN*> st;
+  st.push(from.root);
+  while (!st.empty()) {
+    PN* p = st.pop();
+    enqueue(p->value);
+    if (p->sibling != nullptr)
+      st.push(p->sibling);
+    if (p->child != nullptr)
+      st.push(p->child);
+  }
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+void PairingHeapPriorityQueue<T,tgt>::value_pointers(const T** answer) const {
+  if (root == nullptr)
+    return;
+
+  ArrayStack<PN*> st;
+  st.push(root);
+  while (!st.empty()) {
+    PN* p = st.pop();
+    *answer++ = &p->value;
+    if (p->sibling != nullptr)
+      st.push(p->sibling);
+    if (p->child != nullptr)
+      st.push(p->child);
+  }
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+auto PairingHeapPriorityQueue<T,tgt>::new_node(const T& v) -> PN* {
+  if (pool == nullptr)
+    pool = new NodePool();
+
+  PN* n;
+  if (pool->free != nullptr) {
+    n = pool->free;
+    pool->free = n->sibling;
+    if (pool->free == nullptr)
+      pool->free_tail = nullptr;
+  }else{
+    if (pool->fresh_left == 0) {
+      pool->fresh      = new PN[pool->next_length];
+      pool->blocks.push(pool->fresh);
+      pool->fresh_left = pool->next_length;
+      pool->next_length *= 2;
+    }
+    n = pool->fresh++;
+    --pool->fresh_left;
+    n->pool = pool;
+  }
+
+  n->value = v;
+  n->child = n->sibling = n->prev = nullptr;
+  return n;
+}
+
+
+//The value is reset so that the pool does not keep what it holds alive
+template<class T, bool (*tgt)(const T& a, const T& b)>
+void PairingHeapPriorityQueue<T,tgt>::free_node(PN* n) {
+  ++n->generation;
+  n->value   = T();
+  n->child   = n->prev = nullptr;
+  n->sibling = pool->free;
+  if (pool->free == nullptr)
+    pool->free_tail = n;
+  pool->free = n;
+}
+
+
+//Rotating each child up into the sibling chain flattens the tree without a stack
+template<class T, bool (*tgt)(const T& a, const T& b)>
+void PairingHeapPriorityQueue<T,tgt>::free_nodes(PN* n) {
+  while (n != nullptr)
+    if (n->child == nullptr) {
+      PN* to_free = n;
+      n = n->sibling;
+      free_node(to_free);
+    }else{
+      PN* c = n->child;
+      n->child = c->sibling;
+      c->sibling = n;
+      n = c;
+    }
+}
+
+
+//Find the root of n's pool's merged_into chain, then point the chain's pools straight at it
+template<class T, bool (*tgt)(const T& a, const T& b)>
+bool PairingHeapPriorityQueue<T,tgt>::owns(PN* n) const {
+  NodePool* top = n->pool;
+  while (top->merged_into != nullptr)
+    top = top->merged_into;
+  for (NodePool* p = n->pool; p != top; ) {
+    NodePool* next = p->merged_into;
+    p->merged_into = top;
+    p = next;
+  }
+
+  return top == pool;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+void PairingHeapPriorityQueue<T,tgt>::check_handle(Handle h, const char* where) const {
+  if (!contains(h))
+    throw KeyError(std::string("PairingHeapPriorityQueue::") + where + ": Handle names no value in this queue");
+}
+
+
+//The same rotation as free_nodes, over absorbed/next_absorbed
+template<class T, bool (*tgt)(const T& a, const T& b)>
+void PairingHeapPriorityQueue<T,tgt>::delete_pools(NodePool* p) {
+  while (p != nullptr)
+    if (p->absorbed == nullptr) {
+      NodePool* to_delete = p;
+      p = p->next_absorbed;
+      delete to_delete;
+    }else{
+      NodePool* c = p->absorbed;
+      p->absorbed = c->next_absorbed;
+      c->next_absorbed = p;
+      p = c;
+    }
+}
+
+}
+
+#endif /* PAIRING_HEAP_PRIORITY_QUEUE_HPP_ */
@@ -0,0 +1,77 @@
+#ifndef PRIORITY_QUEUE_EQUAL_HPP_
+#define PRIORITY_QUEUE_EQUAL_HPP_
+
+#include <utility>              //For std::swap/std::declval
+#include <algorithm>            //For std::sort
+#include <type_traits>          //For std::true_type/std::false_type (see pq_same_run)
+
+
+namespace ics {
+
+
+//Equality shared by the priority queues: l[0..n) and r[0..n) point to the values of two queues
+//  (in any order) ordered by the same gt. Both are sorted by priority; values with equal priority
+//  may come out in any order, so each run of equal priority in l must match (as a multiset, using
+//  ==) the values at the same positions in r. Reorders l and r.
+//If T has operator < (consistent with ==), a run is matched by sorting both sides by it, so the
+//  whole comparison is O(n log n); otherwise each value is matched by a linear search: O(run^2).
+template<class T>
+bool priority_queue_equal (const T** l, const T** r, int n, bool (*gt)(const T& a, const T& b));
+
+
+template <class U>
+auto pq_has_less (int)  -> decltype(bool(std::declval<const U&>() < std::declval<const U&>()), std::true_type());
+template <class U>
+std::false_type pq_has_less (long);
+
+
+template<class T>
+bool pq_same_run (const T** l, const T** r, int n, std::true_type) {
+  if (n == 1)
+    return *l[0] == *r[0];
+
+  std::sort(l, l+n, [] (const T* a, const T* b) {return *a < *b;});
+  std::sort(r, r+n, [] (const T* a, const T* b) {return *a < *b;});
+  for (int i=0; i<n; ++i)
+    if (!(*l[i] == *r[i]))
+      return false;
+
+  return true;
+}
+
+
+//r[0..matched) are the values of r already matched
+template<class T>
+bool pq_same_run (const T** l, const T** r, int n, std::false_type) {
+  for (int i=0, matched=0; i<n; ++i, ++matched) {
+    int j = matched;
+    while (j < n && !(*l[i] == *r[j]))
+      ++j;
+    if (j == n)
+      return false;
+    std::swap(r[matched],r[j]);
+  }
+
+  return true;
+}
+
+
+template<class T>
+bool priority_queue_equal (const T** l, const T** r, int n, bool (*gt)(const T& a, const T& b)) {
+  auto higher = [gt] (const T* a, const T* b) {return gt(*a,*b);};
+  std::sort(l, l+n, higher);
+  std::sort(r, r+n, higher);
+
+  for (int run = 0, end; run < n; run = end) {
+    for (end = run+1; end < n && !gt(*l[run],*l[end]); ++end)
+      ;
+    if (!pq_same_run(l+run, r+run, end-run, decltype(pq_has_less<T>(0))()))
+      return false;
+  }
+
+  return true;
+}
+
+}
+
+#endif /* PRIORITY_QUEUE_EQUAL_HPP_ */
@@ -10,6 +10,7 @@
 #include "ics46goody.hpp"
 #include "array_queue.hpp"
 #include "q6utility.hpp"
+#include "fork_join_pool.hpp"
 
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -122,4 +123,79 @@ double test_swapping(int length, int num_tests) {
 }
 
 
+////////////////////////////////////////////////////////////////////////////////
+
+//Parallel merge sort (merging like Problem 2's merge, but through a heap scratch buffer: merge's
+//  temp array is a variable-length array on the stack, which overflows it for large arrays)
+
+//Merge a[left_low..left_high] and a[right_low..right_high] (adjacent, as in merge), using
+//  temp[0..right_high-left_low] as scratch space
+template<class T>
+void merge(T a[], T temp[], int left_low,  int left_high,
+           int right_low, int right_high) {
+  int length = right_high-left_low+1;
+  int left  = left_low;
+  int right = right_low;
+  for (int i = 0; i< length; ++i) {
+    if (left > left_high)
+      temp[i] = a[right++];
+    else if (right > right_high)
+      temp[i] = a[left++];
+    else if (a[left] <= a[right])
+      temp[i] = a[left++];
+    else
+      temp[i] = a[right++];
+  }
+  for (int i=0; i< length; ++i)
+    a[left_low++] = temp[i];
+}
+
+
+//Sort a[low..high] (inclusive bounds, like merge's); temp[0..high-low] is scratch space
+template<class T>
+void merge_sort(T a[], T temp[], int low, int high) {
+  if (low >= high)
+    return;
+  int mid = (low+high)/2;
+  merge_sort(a,temp,low,mid);
+  merge_sort(a,temp,mid+1,high);
+  merge(a,temp,low,mid,mid+1,high);
+}
+
+
+//Each call sorts a[low..high] using temp[0..high-low]; the halves use disjoint parts of temp, so
+//  concurrent merges never share scratch space
+template<class T>
+void parallel_merge_sort(ics::ForkJoinPool& pool, T a[], T temp[], int low, int high, int grain) {
+  if (high-low+1 <= grain) {
+    merge_sort(a,temp,low,high);
+    return;
+  }
+  int mid = (low+high)/2;
+  ics::ForkJoinPool::TaskGroup left;
+  pool.spawn(left, [&pool,a,temp,low,mid,grain] {parallel_merge_sort(pool,a,temp,low,mid,grain);});
+  parallel_merge_sort(pool,a,temp+(mid+1-low),mid+1,high,grain);
+  pool.sync(left);
+  merge(a,temp,low,mid,mid+1,high);
+}
+
+
+//Sort a[low..high]: sort the left half in a spawned task while this thread sorts the right half;
+//  pieces of at most grain values are sorted sequentially. All merges share one scratch array
+//  (allocated here, on the heap) of high-low+1 values.
+template<class T>
+void parallel_merge_sort(ics::ForkJoinPool& pool, T a[], int low, int high, int grain = 4096) {
+  if (low >= high)
+    return;
+  T* temp = new T[high-low+1];
+  try {
+    parallel_merge_sort(pool,a,temp,low,high,grain);
+  } catch (...) {
+    delete[] temp;
+    throw;
+  }
+  delete[] temp;
+}
+
+
 #endif /* Q6SOLUTION_HPP_ */
@@ -0,0 +1,682 @@
+#ifndef RING_BUFFER_QUEUE_HPP_
+#define RING_BUFFER_QUEUE_HPP_
+
+#include <string>
+#include <iostream>
+#include <sstream>
+#include <initializer_list>
+#include <new>                  //For placement new (see enqueue)
+#include <utility>              //For std::move/std::forward
+#include "ics_exceptions.hpp"
+#include "fast_range.hpp"
+
+
+namespace ics {
+
+
+//A queue stored in a circular array whose length is a power of two, so the i-th value (from
+//  the front) is at q[(front+i) & (length-1)]: no division and no per-value allocation.
+//A growable queue doubles its length when full (amortized O(1) enqueue); a fixed one (for
+//  bounded queues between pipeline stages) never reallocates: enqueue returns 0 when it is full.
+//peek_span/discard_front let a consumer process the front values in place, a contiguous
+//  run at a time, without dequeueing (copying/moving) them one by one.
+template<class T> class RingBufferQueue {
+  public:
+    //Destructor/Constructors
+    ~RingBufferQueue();
+
+    //initial_length is rounded up to a power of two; if !growable it is the fixed capacity
+    explicit RingBufferQueue (int initial_length = 0, bool growable = true);
+    RingBufferQueue          (const RingBufferQueue<T>& to_copy);
+    explicit RingBufferQueue (const std::initializer_list<T>& il);
+
+    //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
+    template <class Iterable>
+    explicit RingBufferQueue (const Iterable& i);
+
+
+    //Queries
+    bool empty      () const;
+    int  size       () const;
+    int  capacity   () const;     //size() before the next enqueue must grow (or fail, if fixed)
+    bool full       () const;     //Only a fixed queue is ever full
+    T&   peek       () const;
+    int  peek_span  (T*& first) const; //first..first+answer-1: the front values contiguous in memory
+    std::string str () const; //supplies useful debugging information; contrast to operator <<
+
+
+    //Commands
+    int  enqueue       (const T& element);  //returns 0 (and does nothing) if full()
+    int  enqueue       (T&& element);
+    T    dequeue       ();
+    void discard_front (int n);             //Remove the n front values (e.g., after using a span)
+    void clear         ();
+
+    //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
+    template <class Iterable>
+    int enqueue_all (const Iterable& i);
+
+
+    //Operators
+    RingBufferQueue<T>& operator = (const RingBufferQueue<T>& rhs);
+    bool operator == (const RingBufferQueue<T>& rhs) const;
+    bool operator != (const RingBufferQueue<T>& rhs) const;
+
+    template<class T2>
+    friend std::ostream& operator << (std::ostream& outs, const RingBufferQueue<T2>& q);
+
+
+    class Iterator {
+      public:
+        //Private constructor called in begin/end, which are friends of RingBufferQueue<T>
+        ~Iterator();
+        T           erase();
+        std::string str  () const;
+        RingBufferQueue<T>::Iterator& operator ++ ();
+        RingBufferQueue<T>::Iterator  operator ++ (int);
+        bool operator == (const RingBufferQueue<T>::Iterator& rhs) const;
+        bool operator != (const RingBufferQueue<T>::Iterator& rhs) const;
+        T& operator *  () const;
+        T* operator -> () const;
+        friend std::ostream& operator << (std::ostream& outs, const RingBufferQueue<T>::Iterator& i) {
+          outs << i.str(); //Use the same meaning as the debugging .str() method
+          return outs;
+        }
+        friend Iterator RingBufferQueue<T>::begin () const;
+        friend Iterator RingBufferQueue<T>::end   () const;
+
+      private:
+        //If can_erase is false, current indexes the "next" value (must ++ to reach it)
+        int                 current;     //Index (from the front) of the current value
+        RingBufferQueue<T>* ref_queue;
+        int                 expected_mod_count;
+        bool                can_erase = true;
+
+        //Called in friends begin/end
+        Iterator(RingBufferQueue<T>* iterate_over, int initial);
+    };
+
+
+    Iterator begin () const;
+    Iterator end   () const;
+
+
+    //Unchecked iterator for hot loops: no mod_count/dynamic_cast checks and no erase.
+    //The queue must not be changed while one is in use; see ics::fast above for a "for-each" loop
+    class FastIterator {
+      public:
+        RingBufferQueue<T>::FastIterator& operator ++ ();
+        bool operator == (const RingBufferQueue<T>::FastIterator& rhs) const;
+        bool operator != (const RingBufferQueue<T>::FastIterator& rhs) const;
+        T& operator *  () const;
+        T* operator -> () const;
+
+        friend FastIterator RingBufferQueue<T>::fast_begin () const;
+        friend FastIterator RingBufferQueue<T>::fast_end   () const;
+
+      private:
+        T*  q;
+        int mask;
+        int front;
+        int current;   //Index (from the front) of the current value: counted, so a full q's begin != end
+
+        //Called in friends fast_begin/fast_end
+        FastIterator(T* q, int mask, int front, int initial);
+    };
+
+
+    FastIterator fast_begin () const;
+    FastIterator fast_end   () const;
+
+
+  private:
+    T*   q;                        //Raw storage: only the used values from front (circularly) are constructed
+    int  length    = 1;            //Physical length of q: a power of two
+    int  front     = 0;            //Index of the front value in q
+    int  used      = 0;            //Number of values: invariant: 0 <= used <= length
+    bool growable  = true;
+    int  mod_count = 0;            //For sensing concurrent modification
+
+    //Helper methods
+    T&   at            (int i) const;   //The i-th value from the front
+    int  mask          () const;        //length-1
+    template <class... Args>
+    void append        (Args&&... args);      //Construct the value after the rear from args (which may refer into q)
+    void destroy_all   ();              //Destroy the values (but leave q allocated); used = front = 0
+    static int round_up (int n);        //Least power of two >= n (and >= 1)
+    static T*  allocate (int length);
+};
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//RingBufferQueue class and related definitions
+
+//Destructor/Constructors
+
+template<class T>
+RingBufferQueue<T>::~RingBufferQueue() {
+  destroy_all();
+  ::operator delete(q);
+}
+
+
+template<class T>
+RingBufferQueue<T>::RingBufferQueue(int initial_length, bool growable)
+: length(round_up(initial_length)), growable(growable) {
+  q = allocate(length);
+}
+
+
+template<class T>
+RingBufferQueue<T>::RingBufferQueue(const RingBufferQueue<T>& to_copy)
+: length(to_copy.length), used(to_copy.used), growable(to_copy.growable) {
+  q = allocate(length);
+  for (int i=0; i<used; ++i)
+    new (q+i) T(to_copy.at(i));
+}
+
+
+template<class T>
+RingBufferQueue<T>::RingBufferQueue(const std::initializer_list<T>& il)
+: length(round_up(il.size())) {
+  q = allocate(length);
+  for (const T& q_elem : il)
+    enqueue(q_elem);
+}
+
+
+template<class T>
+template<class Iterable>
+RingBufferQueue<T>::RingBufferQueue(const Iterable& i) {
+  q = allocate(length);
+  for (const T& v : i)
+    enqueue(v);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Queries
+
+template<class T>
+bool RingBufferQueue<T>::empty() const {
+  return used == 0;
+}
+
+
+template<class T>
+int RingBufferQueue<T>::size() const {
+  return used;
+}
+
+
+template<class T>
+int RingBufferQueue<T>::capacity() const {
+  return length;
+}
+
+
+template<class T>
+bool RingBufferQueue<T>::full() const {
+  return !growable && used == length;
+}
+
+
+template<class T>
+T& RingBufferQueue<T>::peek () const {
+  if (this->empty())
+    throw EmptyError("RingBufferQueue::peek");
+
+  return q[front];
+}
+
+
+//The front values, up to the end of q (or the rear): after discard_front(answer), a second call
+//  returns the rest (if the values wrapped around)
+template<class T>
+int RingBufferQueue<T>::peek_span (T*& first) const {
+  first = q+front;
+  return front+used <= length ? used : length-front;
+}
+
+
+template<class T>
+std::string RingBufferQueue<T>::str() const {
+  std::ostringstream answer;
+  answer << "RingBufferQueue[";
+
+  for (int i=0; i<length; ++i) {
+    answer << (i == 0 ? "" : ",") << i << ":";
+    if (((i-front) & mask()) < used)
+      answer << q[i];
+  }
+
+  answer << "](length=" << length << ",front=" << front << ",used=" << used
+         << ",growable=" << growable << ",mod_count=" << mod_count << ")";
+  return answer.str();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Commands
+
+template<class T>
+int RingBufferQueue<T>::enqueue(const T& element) {
+  if (full())
+    return 0;
+
+  append(element);
+  ++mod_count;
+  return 1;
+}
+
+
+template<class T>
+int RingBufferQueue<T>::enqueue(T&& element) {
+  if (full())
+    return 0;
+
+  append(std::move(element));
+  ++mod_count;
+  return 1;
+}
+
+
+template<class T>
+T RingBufferQueue<T>::dequeue() {
+  if (this->empty())
+    throw EmptyError("RingBufferQueue::dequeue");
+
+  T answer = std::move(q[front]);
+  q[front].~T();
+  front = (front+1) & mask();
+  --used;
+  ++mod_count;
+  return answer;
+}
+
+
+template<class T>
+void RingBufferQueue<T>::discard_front(int n) {
+  if (n > used)
+    throw EmptyError("RingBufferQueue::discard_front");
+
+  for (int i=0; i<n; ++i) {
+    q[front].~T();
+    front = (front+1) & mask();
+  }
+  used -= n;
+  ++mod_count;
+}
+
+
+template<class T>
+void RingBufferQueue<T>::clear() {
+  destroy_all();
+  ++mod_count;
+}
+
+
+template<class T>
+template<class Iterable>
+int RingBufferQueue<T>::enqueue_all(const Iterable& i) {
+  int count = 0;
+  for (const T& v : i)
+     count += enqueue(v);
+
+    return count;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Operators
+
+template<class T>
+RingBufferQueue<T>& RingBufferQueue<T>::operator = (const RingBufferQueue<T>& rhs) {
+  if (this == &rhs)
+    return *this;
+
+  destroy_all();
+  growable = rhs.growable;
+  if (length < rhs.used || !growable) {
+    ::operator delete(q);
+    length = (growable ? round_up(rhs.used) : rhs.length);
+    q = allocate(length);
+  }
+  for (int i=0; i<rhs.used; ++i)
+    new (q+i) T(rhs.at(i));
+  used = rhs.used;
+
+  ++mod_count;
+  return *this;
+}
+
+
+template<class T>
+bool RingBufferQueue<T>::operator == (const RingBufferQueue<T>& rhs) const {
+  if (this == &rhs)
+    return true;
+  if (used != rhs.size())
+    return false;
+  for (int i=0; i<used; ++i)
+    if (at(i) != rhs.at(i))
+      return false;
+
+  return true;
+}
+
+
+template<class T>
+bool RingBufferQueue<T>::operator != (const RingBufferQueue<T>& rhs) const {
+  return !(*this == rhs);
+}
+
+
+template<class T>
+std::ostream& operator << (std::ostream& outs, const RingBufferQueue<T>& q) {
+  outs << "queue[";
+
+  for (int i=0; i<q.used; ++i)
+    outs << (i == 0 ? "" : ",") << q.at(i);
+
+  outs << "]:rear";
+  return outs;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Iterator constructors
+
+template<class T>
+auto RingBufferQueue<T>::begin () const -> RingBufferQueue<T>::Iterator {
+  return Iterator(const_cast<RingBufferQueue<T>*>(this),0);
+}
+
+template<class T>
+auto RingBufferQueue<T>::end () const -> RingBufferQueue<T>::Iterator {
+  return Iterator(const_cast<RingBufferQueue<T>*>(this),used);
+}
+
+
+template<class T>
+auto RingBufferQueue<T>::fast_begin () const -> RingBufferQueue<T>::FastIterator {
+  return FastIterator(q,mask(),front,0);
+}
+
+
+template<class T>
+auto RingBufferQueue<T>::fast_end () const -> RingBufferQueue<T>::FastIterator {
+  return FastIterator(q,mask(),front,used);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Private helper methods
+
+template<class T>
+T& RingBufferQueue<T>::at(int i) const {
+  return q[(front+i) & mask()];
+}
+
+
+template<class T>
+int RingBufferQueue<T>::mask() const {
+  return length-1;
+}
+
+
+//When q is full, the new value is constructed in the new storage before the old values are moved
+//  there and destroyed: args may refer to one of them (as in q.enqueue(q.peek()))
+template<class T>
+template <class... Args>
+void RingBufferQueue<T>::append(Args&&... args) {
+  if (used < length) {
+    new (&at(used)) T(std::forward<Args>(args)...);
+    ++used;
+    return;
+  }
+
+  int new_length = 2*length;
+  T*  new_q      = allocate(new_length);
+  new (new_q+used) T(std::forward<Args>(args)...);
+  for (int i=0; i<used; ++i) {
+    T& old = at(i);
+    new (new_q+i) T(std::move(old));
+    old.~T();
+  }
+
+  ::operator delete(q);
+  q      = new_q;
+  length = new_length;
+  front  = 0;
+  ++used;
+}
+
+
+template<class T>
+void RingBufferQueue<T>::destroy_all() {
+  for (int i=0; i<used; ++i)
+    at(i).~T();
+  used = front = 0;
+}
+
+
+template<class T>
+int RingBufferQueue<T>::round_up(int n) {
+  int answer = 1;
+  while (answer < n)
+    answer <<= 1;
+  return answer;
+}
+
+
+template<class T>
+T* RingBufferQueue<T>::allocate(int length) {
+  return static_cast<T*>(::operator new(length*sizeof(T)));
+}
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Iterator class definitions
+
+template<class T>
+RingBufferQueue<T>::Iterator::Iterator(RingBufferQueue<T>* iterate_over, int initial)
+: current(initial), ref_queue(iterate_over), expected_mod_count(ref_queue->mod_count) {
+}
+
+
+template<class T>
+RingBufferQueue<T>::Iterator::~Iterator()
+{}
+
+
+//Close the gap by moving whichever side of current has fewer values; either way, the next
+//  value ends up at index current (from the front)
+template<class T>
+T RingBufferQueue<T>::Iterator::erase() {
+  if (expected_mod_count != ref_queue->mod_count)
+    throw ConcurrentModificationError("RingBufferQueue::Iterator::erase");
+  if (!can_erase)
+    throw CannotEraseError("RingBufferQueue::Iterator::erase Iterator cursor already erased");
+  if (current >= ref_queue->used)
+    throw CannotEraseError("RingBufferQueue::Iterator::erase Iterator cursor beyond data structure");
+
+  can_erase = false;
+  RingBufferQueue<T>& rq = *ref_queue;
+  T to_return = std::move(rq.at(current));
+
+  if (current < rq.used/2) {
+    for (int i=current; i>0; --i)
+      rq.at(i) = std::move(rq.at(i-1));
+    rq.at(0).~T();
+    rq.front = (rq.front+1) & rq.mask();
+  }else{
+    for (int i=current+1; i<rq.used; ++i)
+      rq.at(i-1) = std::move(rq.at(i));
+    rq.at(rq.used-1).~T();
+  }
+
+  --rq.used;
+  expected_mod_count = ++rq.mod_count;
+  return to_return;
+}
+
+
+template<class T>
+std::string RingBufferQueue<T>::Iterator::str() const {
+  std::ostringstream answer;
+  answer << ref_queue->str() << "(current=" << current << ",expected_mod_count=" << expected_mod_count << ",can_erase=" << can_erase << ")";
+  return answer.str();
+}
+
+
+template<class T>
+auto RingBufferQueue<T>::Iterator::operator ++ () -> RingBufferQueue<T>::Iterator& {
+  if (expected_mod_count != ref_queue->mod_count)
+    throw ConcurrentModificationError("RingBufferQueue::Iterator::operator ++");
+
+  if (current >= ref_queue->used)
+    return *this;
+
+  if (can_erase)
+    ++current;
+  else
+    can_erase = true;
+
+  return *this;
+}
+
+
+template<class T>
+auto RingBufferQueue<T>::Iterator::operator ++ (int) -> RingBufferQueue<T>::Iterator {
+  if (expected_mod_count != ref_queue->mod_count)
+    throw ConcurrentModificationError("RingBufferQueue::Iterator::operator ++(int)");
+
+  if (current >= ref_queue->used)
+    return *this;
+
+  Iterator to_return(*this);
+
+  if (can_erase)
+    ++current;
+  else
+    can_erase = true;
+
+  return to_return;
+}
+
+
+template<class T>
+bool RingBufferQueue<T>::Iterator::operator == (const RingBufferQueue<T>::Iterator& rhs) const {
+  const Iterator* rhsASI = dynamic_cast<const Iterator*>(&rhs);
+  if (rhsASI == 0)
+    throw IteratorTypeError("RingBufferQueue::Iterator::operator ==");
+  if (expected_mod_count != ref_queue->mod_count)
+    throw ConcurrentModificationError("RingBufferQueue::Iterator::operator ==");
+  if (ref_queue != rhsASI->ref_queue)
+    throw ComparingDifferentIteratorsError("RingBufferQueue::Iterator::operator ==");
+
+  return current == rhsASI->current;
+}
+
+
+template<class T>
+bool RingBufferQueue<T>::Iterator::operator != (const RingBufferQueue<T>::Iterator& rhs) const {
+  const Iterator* rhsASI = dynamic_cast<const Iterator*>(&rhs);
+  if (rhsASI == 0)
+    throw IteratorTypeError("RingBufferQueue::Iterator::operator !=");
+  if (expected_mod_count != ref_queue->mod_count)
+    throw ConcurrentModificationError("RingBufferQueue::Iterator::operator !=");
+  if (ref_queue != rhsASI->ref_queue)
+    throw ComparingDifferentIteratorsError("RingBufferQueue::Iterator::operator !=");
+
+  return current != rhsASI->current;
+}
+
+
+template<class T>
+T& RingBufferQueue<T>::Iterator::operator *() const {
+  if (expected_mod_count != ref_queue->mod_count)
+    throw ConcurrentModificationError("RingBufferQueue::Iterator::operator *");
+  if (!can_erase || current >= ref_queue->used) {
+    std::ostringstream where;
+    where << current << " when size = " << ref_queue->used;
+    throw IteratorPositionIllegal("RingBufferQueue::Iterator::operator * Iterator illegal: "+where.str());
+  }
+
+  return ref_queue->at(current);
+}
+
+
+template<class T>
+T* RingBufferQueue<T>::Iterator::operator ->() const {
+  if (expected_mod_count != ref_queue->mod_count)
+    throw ConcurrentModificationError("RingBufferQueue::Iterator::operator ->");
+  if (!can_erase || current >= ref_queue->used) {
+    std::ostringstream where;
+    where << current << " when size = " << ref_queue->used;
+    throw IteratorPositionIllegal("RingBufferQueue::Iterator::operator -> Iterator illegal: "+where.str());
+  }
+
+  return &ref_queue->at(current);
+}
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//FastIterator class definitions
+
+template<class T>
+RingBufferQueue<T>::FastIterator::FastIterator(T* q, int mask, int front, int initial)
+: q(q), mask(mask), front(front), current(initial) {
+}
+
+
+template<class T>
+auto RingBufferQueue<T>::FastIterator::operator ++ () -> RingBufferQueue<T>::FastIterator& {
+  ++current;
+  return *this;
+}
+
+
+template<class T>
+bool RingBufferQueue<T>::FastIterator::operator == (const RingBufferQueue<T>::FastIterator& rhs) const {
+  return current == rhs.current;
+}
+
+
+template<class T>
+bool RingBufferQueue<T>::FastIterator::operator != (const RingBufferQueue<T>::FastIterator& rhs) const {
+  return current != rhs.current;
+}
+
+
+template<class T>
+T& RingBufferQueue<T>::FastIterator::operator *() const {
+  return q[(front+current) & mask];
+}
+
+
+template<class T>
+T* RingBufferQueue<T>::FastIterator::operator ->() const {
+  return &q[(front+current) & mask];
+}
+
+
+}
+
+#endif /* RING_BUFFER_QUEUE_HPP_ */
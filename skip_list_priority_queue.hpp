@@ -0,0 +1,718 @@
+#ifndef SKIP_LIST_PRIORITY_QUEUE_HPP_
+#define SKIP_LIST_PRIORITY_QUEUE_HPP_
+
+#include <string>
+#include <iostream>
+#include <sstream>
+#include <initializer_list>
+#include <cstdint>
+#include "ics_exceptions.hpp"
+#include "array_stack.hpp"      //See operator <<
+#include "priority_queue_equal.hpp"
+#include "fast_range.hpp"
+
+
+namespace ics {
+
+
+#ifndef undefinedgtdefined
+#define undefinedgtdefined
+template<class T>
+bool undefinedgt (const T& a, const T& b) {return false;}
+#endif /* undefinedgtdefined */
+
+//The LinkedPriorityQueue interface on a skip list: the level 0 list is in priority order (so
+//  dequeue and iteration are the same as LinkedPriorityQueue's), and each node is also linked
+//  into a random number of higher levels (1/2 the nodes at level 1, 1/4 at level 2, ...), so
+//  enqueue finds its place in O(log N) expected time instead of walking the whole list.
+//Values of equal priority are dequeued/iterated in FIFO order (enqueue places a value after
+//  all values it does not have higher priority than).
+//
+//Instantiate the templated class supplying tgt(a,b): true, iff a has higher priority than b.
+//If tgt is defaulted to undefinedgt in the template, then a constructor must supply cgt.
+//If both tgt and cgt are supplied, then they must be the same (by ==) function.
+//If neither is supplied, or both are supplied but different, TemplateFunctionError is raised.
+//The (unique) non-undefinedgt value supplied by tgt/cgt is stored in the instance variable gt.
+template<class T, bool (*tgt)(const T& a, const T& b) = undefinedgt<T>> class SkipListPriorityQueue {
+  public:
+    typedef bool (*gtfunc) (const T& a, const T& b);
+
+    //Destructor/Constructors
+    ~SkipListPriorityQueue();
+
+    SkipListPriorityQueue          (bool (*cgt)(const T& a, const T& b) = undefinedgt<T>);
+    SkipListPriorityQueue          (const SkipListPriorityQueue<T,tgt>& to_copy, bool (*cgt)(const T& a, const T& b) = undefinedgt<T>);
+    explicit SkipListPriorityQueue (const std::initializer_list<T>& il, bool (*cgt)(const T& a, const T& b) = undefinedgt<T>);
+
+    //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
+    template <class Iterable>
+    explicit SkipListPriorityQueue (const Iterable& i, bool (*cgt)(const T& a, const T& b) = undefinedgt<T>);
+
+
+    //Queries
+    bool empty      () const;
+    int  size       () const;
+    T&   peek       () const;
+    std::string str () const; //supplies useful debugging information; contrast to operator <<
+
+
+    //Commands
+    int  enqueue (const T& element);
+    T    dequeue ();
+    void clear   ();
+
+    //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
+    template <class Iterable>
+    int enqueue_all (const Iterable& i);
+
+
+    //Operators
+    SkipListPriorityQueue<T,tgt>& operator = (const SkipListPriorityQueue<T,tgt>& rhs);
+    bool operator == (const SkipListPriorityQueue<T,tgt>& rhs) const;
+    bool operator != (const SkipListPriorityQueue<T,tgt>& rhs) const;
+
+    template<class T2, bool (*gt2)(const T2& a, const T2& b)>
+    friend std::ostream& operator << (std::ostream& outs, const SkipListPriorityQueue<T2,gt2>& pq);
+
+
+
+  private:
+    class SN;
+
+  public:
+    class Iterator {
+      public:
+        //Private constructor called in begin/end, which are friends of SkipListPriorityQueue<T,tgt>
+        ~Iterator();
+        T           erase();
+        std::string str  () const;
+        SkipListPriorityQueue<T,tgt>::Iterator& operator ++ ();
+        SkipListPriorityQueue<T,tgt>::Iterator  operator ++ (int);
+        bool operator == (const SkipListPriorityQueue<T,tgt>::Iterator& rhs) const;
+        bool operator != (const SkipListPriorityQueue<T,tgt>::Iterator& rhs) const;
+        T& operator *  () const;
+        T* operator -> () const;
+        friend std::ostream& operator << (std::ostream& outs, const SkipListPriorityQueue<T,tgt>::Iterator& i) {
+          outs << i.str(); //Use the same meaning as the debugging .str() method
+          return outs;
+        }
+        friend Iterator SkipListPriorityQueue<T,tgt>::begin () const;
+        friend Iterator SkipListPriorityQueue<T,tgt>::end   () const;
+
+      private:
+        //If can_erase is false, current indexes the "next" value (must ++ to reach it)
+        SN*             prev;            //prev (at level 0) should be initalized to the header
+        SN*             current;         //current == prev->next[0]
+        SkipListPriorityQueue<T,tgt>* ref_pq;
+        int             expected_mod_count;
+        bool            can_erase = true;
+
+        //Called in friends begin/end
+        Iterator(SkipListPriorityQueue<T,tgt>* iterate_over, SN* initial);
+    };
+
+
+    Iterator begin () const;
+    Iterator end   () const;
+
+
+    //Unchecked iterator for hot loops: no mod_count/dynamic_cast checks and no erase.
+    //The priority queue must not be changed while one is in use; see ics::fast above for a "for-each" loop
+    class FastIterator {
+      public:
+        SkipListPriorityQueue<T,tgt>::FastIterator& operator ++ ();
+        bool operator == (const SkipListPriorityQueue<T,tgt>::FastIterator& rhs) const;
+        bool operator != (const SkipListPriorityQueue<T,tgt>::FastIterator& rhs) const;
+        T& operator *  () const;
+        T* operator -> () const;
+
+        friend FastIterator SkipListPriorityQueue<T,tgt>::fast_begin () const;
+        friend FastIterator SkipListPriorityQueue<T,tgt>::fast_end   () const;
+
+      private:
+        SN* current;
+
+        //Called in friends fast_begin/fast_end
+        FastIterator(SN* initial);
+    };
+
+
+    FastIterator fast_begin () const;
+    FastIterator fast_end   () const;
+
+
+  private:
+    static const int max_level = 32;
+
+    class SN {
+      public:
+        SN (int height)             : height(height), next(new SN*[height]) {for (int i=0; i<height; ++i) next[i] = nullptr;}
+        SN (const T& v, int height) : value(v), height(height), next(new SN*[height]) {for (int i=0; i<height; ++i) next[i] = nullptr;}
+        ~SN ()                      {delete[] next;}
+
+        T    value;
+        int  height;
+        SN** next;                       //next[i] is the following node at level i
+    };
+
+
+    bool (*gt) (const T& a, const T& b); // The gt used by enqueue (from template or constructor)
+    SN* front         = new SN(max_level); //Header node: linked into every level
+    int levels        = 1;               //Levels 0..levels-1 may be non-empty
+    int used          = 0;               //Cache for number of values in skip list
+    int mod_count     = 0;               //For sensing concurrent modification
+    std::uint32_t random_state = 0x9E3779B9u;
+
+    //Helper methods
+    int  random_height ();               //1 + # of heads flipped in a row (at most max_level)
+    void append        (const SkipListPriorityQueue<T,tgt>& from);  //Copy from's values, in order, to an empty list
+    void unlink        (SN* prev0, SN* n);  //Remove n (prev0->next[0] == n) from every level and delete it
+    void delete_list   ();               //Deallocate all SNs after the header
+};
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//SkipListPriorityQueue class and related definitions
+
+//Destructor/Constructors
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+SkipListPriorityQueue<T,tgt>::~SkipListPriorityQueue() {
+  delete_list();
+  delete front;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+SkipListPriorityQueue<T,tgt>::SkipListPriorityQueue(bool (*cgt)(const T& a, const T& b))
+: gt(tgt != (gtfunc)undefinedgt<T> ? tgt : cgt) {
+  if (gt == (gtfunc)undefinedgt<T>) {
+    delete front; //delete allocated header node to avoid memory leak
+    throw TemplateFunctionError("SkipListPriorityQueue::default constructor: neither specified");
+  }
+  if (tgt != (gtfunc)undefinedgt<T> && cgt != (gtfunc)undefinedgt<T> && tgt != cgt) {
+    delete front; //delete allocated header node to avoid memory leak
+    throw TemplateFunctionError("SkipListPriorityQueue::default constructor: both specified and different");
+  }
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+SkipListPriorityQueue<T,tgt>::SkipListPriorityQueue(const SkipListPriorityQueue<T,tgt>& to_copy, bool (*cgt)(const T& a, const T& b))
+: gt(tgt != (gtfunc)undefinedgt<T> ? tgt : cgt) {
+  if (gt == (gtfunc)undefinedgt<T>)
+    gt = to_copy.gt;//throw TemplateFunctionError("SkipListPriorityQueue::copy constructor: neither specified");
+  if (tgt != (gtfunc)undefinedgt<T> && cgt != (gtfunc)undefinedgt<T> && tgt != cgt) {
+    delete front; //delete allocated header node to avoid memory leak
+    throw TemplateFunctionError("SkipListPriorityQueue::copy constructor: both specified and different");
+  }
+
+  if (gt == to_copy.gt)
+    append(to_copy);
+  else
+    for (SN* p = to_copy.front->next[0]; p != nullptr; p = p->next[0])
+      enqueue(p->value);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+SkipListPriorityQueue<T,tgt>::SkipListPriorityQueue(const std::initializer_list<T>& il, bool (*cgt)(const T& a, const T& b))
+: gt(tgt != (gtfunc)undefinedgt<T> ? tgt : cgt) {
+  if (gt == (gtfunc)undefinedgt<T>) {
+    delete front; //delete allocated header node to avoid memory leak
+    throw TemplateFunctionError("SkipListPriorityQueue::initializer_list constructor: neither specified");
+  }
+  if (tgt != (gtfunc)undefinedgt<T> && cgt != (gtfunc)undefinedgt<T> && tgt != cgt) {
+    delete front; //delete allocated header node to avoid memory leak
+    throw TemplateFunctionError("SkipListPriorityQueue::initializer_list constructor: both specified and different");
+  }
+
+  for (const T& q_elem : il)
+    enqueue(q_elem);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+template<class Iterable>
+SkipListPriorityQueue<T,tgt>::SkipListPriorityQueue(const Iterable& i, bool (*cgt)(const T& a, const T& b))
+: gt(tgt != (gtfunc)undefinedgt<T> ? tgt : cgt) {
+  if (gt == (gtfunc)undefinedgt<T>) {
+    delete front; //delete allocated header node to avoid memory leak
+    throw TemplateFunctionError("SkipListPriorityQueue::iterable constructor: neither specified");
+  }
+  if (tgt != (gtfunc)undefinedgt<T> && cgt != (gtfunc)undefinedgt<T> && tgt != cgt) {
+    delete front; //delete allocated header node to avoid memory leak
+    throw TemplateFunctionError("SkipListPriorityQueue::iterable constructor: both specified and different");
+  }
+
+  for (const T& v : i)
+    enqueue(v);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Queries
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+bool SkipListPriorityQueue<T,tgt>::empty() const {
+  return used == 0;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+int SkipListPriorityQueue<T,tgt>::size() const {
+  return used;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+T& SkipListPriorityQueue<T,tgt>::peek () const {
+  if (this->empty())
+    throw EmptyError("SkipListPriorityQueue::peek");
+
+  return front->next[0]->value;
+}
+
+
+//Level 0 in order; each value is followed by its height
+template<class T, bool (*tgt)(const T& a, const T& b)>
+std::string SkipListPriorityQueue<T,tgt>::str() const {
+  std::ostringstream answer;
+  answer << "SkipListPriorityQueue[HEADER";
+
+  for (SN* p = front->next[0]; p != nullptr; p = p->next[0])
+    answer << "->" << p->value << "(" << p->height << ")";
+
+  answer << "](used=" << used << ",levels=" << levels << ",front=" << front << ",mod_count=" << mod_count << ")";
+  return answer.str();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Commands
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+int SkipListPriorityQueue<T,tgt>::enqueue(const T& element) {
+  int height = random_height();
+  if (height > levels)
+    levels = height;
+
+  //At each level, from the top, pass every value element does not have higher priority than
+  SN* n = new SN(element,height);
+  SN* p = front;
+  for (int i = levels-1; i >= 0; --i) {
+    while (p->next[i] != nullptr && !gt(element,p->next[i]->value))
+      p = p->next[i];
+    if (i < height) {
+      n->next[i] = p->next[i];
+      p->next[i] = n;
+    }
+  }
+
+  ++used;
+  ++mod_count;
+  return 1;
+}
+
+
+//The first node is first at every level it is in, so it is unlinked from the header alone
+template<class T, bool (*tgt)(const T& a, const T& b)>
+T SkipListPriorityQueue<T,tgt>::dequeue() {
+  if (this->empty())
+    throw EmptyError("SkipListPriorityQueue::dequeue");
+
+  SN* to_delete = front->next[0];
+  T answer = to_delete->value;
+  for (int i=0; i<to_delete->height; ++i)
+    front->next[i] = to_delete->next[i];
+  delete to_delete;
+  while (levels > 1 && front->next[levels-1] == nullptr)
+    --levels;
+
+  --used;
+  ++mod_count;
+  return answer;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+void SkipListPriorityQueue<T,tgt>::clear() {
+  delete_list();
+  used = 0;
+  ++mod_count;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+template <class Iterable>
+int SkipListPriorityQueue<T,tgt>::enqueue_all (const Iterable& i) {
+  int count = 0;
+  for (const T& v : i)
+     count += enqueue(v);
+
+  return count;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Operators
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+SkipListPriorityQueue<T,tgt>& SkipListPriorityQueue<T,tgt>::operator = (const SkipListPriorityQueue<T,tgt>& rhs) {
+  if (this == &rhs)
+    return *this;
+
+  gt = rhs.gt;   // if tgt != nullptr, gts are already equal (or compiler error)
+  delete_list();
+  append(rhs);
+
+  ++mod_count;
+  return *this;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+bool SkipListPriorityQueue<T,tgt>::operator == (const SkipListPriorityQueue<T,tgt>& rhs) const {
+  if (this == &rhs)
+    return true;
+  if (used != rhs.size())
+    return false;
+  if (gt != rhs.gt) //For PriorityQueues to be equal, they need the same gt function, and values
+    return false;
+
+  //Values of equal priority may be in any order (see priority_queue_equal)
+  const T** l = new const T*[used];
+  const T** r = new const T*[used];
+  int i = 0;
+  for (SN* p = front->next[0], *q = rhs.front->next[0]; p != nullptr; p = p->next[0], q = q->next[0], ++i) {
+    l[i] = &p->value;
+    r[i] = &q->value;
+  }
+  bool answer = priority_queue_equal(l,r,used,gt);
+
+  delete[] l;
+  delete[] r;
+  return answer;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+bool SkipListPriorityQueue<T,tgt>::operator != (const SkipListPriorityQueue<T,tgt>& rhs) const {
+  return !(*this == rhs);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+std::ostream& operator << (std::ostream& outs, const SkipListPriorityQueue<T,tgt>& pq) {
+  outs << "priority_queue[";
+
+  if (!pq.empty()) {
+    ArrayStack<T> st;
+    for (typename SkipListPriorityQueue<T,tgt>::SN* p = pq.front->next[0]; p != nullptr; p = p->next[0])
+      st.push(p->value);
+    outs << st.pop();
+    while (!st.empty())
+      outs << "," << st.pop();
+  }
+
+  outs <<"]:highest";
+  return outs;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Iterator constructors
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+auto SkipListPriorityQueue<T,tgt>::begin () const -> SkipListPriorityQueue<T,tgt>::Iterator {
+  return Iterator(const_cast<SkipListPriorityQueue<T,tgt>*>(this),front->next[0]);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+auto SkipListPriorityQueue<T,tgt>::end () const -> SkipListPriorityQueue<T,tgt>::Iterator {
+  return Iterator(const_cast<SkipListPriorityQueue<T,tgt>*>(this),nullptr);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+auto SkipListPriorityQueue<T,tgt>::fast_begin () const -> SkipListPriorityQueue<T,tgt>::FastIterator {
+  return FastIterator(front->next[0]);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+auto SkipListPriorityQueue<T,tgt>::fast_end () const -> SkipListPriorityQueue<T,tgt>::FastIterator {
+  return FastIterator(nullptr);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Private helper methods
+
+//xorshift32: each further level is used with probability 1/2
+template<class T, bool (*tgt)(const T& a, const T& b)>
+int SkipListPriorityQueue<T,tgt>::random_height() {
+  random_state ^= random_state << 13;
+  random_state ^= random_state >> 17;
+  random_state ^= random_state << 5;
+
+  int height = 1;
+  for (std::uint32_t bits = random_state; (bits & 1) != 0 && height < max_level; bits >>= 1)
+    ++height;
+  return height;
+}
+
+
+//Nodes are appended in order, so each level's last node is its insertion point
+template<class T, bool (*tgt)(const T& a, const T& b)>
+void SkipListPriorityQueue<T,tgt>::append(const SkipListPriorityQueue<T,tgt>& from) {
+  SN* last[max_level];
+  for (int i=0; i<max_level; ++i)
+    last[i] = front;
+
+  levels = 1;
+  for (SN* p = from.front->next[0]; p != nullptr; p = p->next[0]) {
+    SN* n = new SN(p->value,p->height);
+    for (int i=0; i<n->height; ++i)
+      last[i] = last[i]->next[i] = n;
+    if (n->height > levels)
+      levels = n->height;
+  }
+  used = from.used;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+void SkipListPriorityQueue<T,tgt>::unlink(SN* prev0, SN* n) {
+  //Above level 0, find n's predecessors top down: pass values of higher priority than n's; then
+  //  (n is in the list at levels < n->height) walk through equal ones until reaching n
+  SN* p = front;
+  for (int i = levels-1; i >= 1; --i) {
+    while (p->next[i] != nullptr && gt(p->next[i]->value,n->value))
+      p = p->next[i];
+    if (i < n->height) {
+      while (p->next[i] != n)
+        p = p->next[i];
+      p->next[i] = n->next[i];
+    }
+  }
+  prev0->next[0] = n->next[0];
+
+  delete n;
+  while (levels > 1 && front->next[levels-1] == nullptr)
+    --levels;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+void SkipListPriorityQueue<T,tgt>::delete_list() {
+  for (SN* p = front->next[0]; p != nullptr; /*see body*/) {
+    SN* to_delete = p;
+    p = p->next[0];
+    delete to_delete;
+  }
+  for (int i=0; i<max_level; ++i)
+    front->next[i] = nullptr;
+  levels = 1;
+}
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Iterator class definitions
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+SkipListPriorityQueue<T,tgt>::Iterator::Iterator(SkipListPriorityQueue<T,tgt>* iterate_over, SN* initial)
+: prev(iterate_over->front), current(initial), ref_pq(iterate_over), expected_mod_count(ref_pq->mod_count) {
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+SkipListPriorityQueue<T,tgt>::Iterator::~Iterator()
+{}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+T SkipListPriorityQueue<T,tgt>::Iterator::erase() {
+  if (expected_mod_count != ref_pq->mod_count)
+    throw ConcurrentModificationError("SkipListPriorityQueue::Iterator::erase");
+  if (!can_erase)
+    throw CannotEraseError("SkipListPriorityQueue::Iterator::erase Iterator cursor already erased");
+  if (current == nullptr)
+    throw CannotEraseError("SkipListPriorityQueue::Iterator::erase Iterator cursor beyond data structure");
+
+  can_erase = false;
+  T to_return = current->value;
+
+  SN* to_delete = current;
+  current = current->next[0];
+  ref_pq->unlink(prev,to_delete);
+
+  --ref_pq->used;
+  expected_mod_count = ++ref_pq->mod_count;
+  return to_return;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+std::string SkipListPriorityQueue<T,tgt>::Iterator::str() const {
+  std::ostringstream answer;
+  answer << ref_pq->str() << "(current=" << current << ",expected_mod_count=" << expected_mod_count << ",can_erase=" << can_erase << ")";
+  return answer.str();
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+auto SkipListPriorityQueue<T,tgt>::Iterator::operator ++ () -> SkipListPriorityQueue<T,tgt>::Iterator& {
+  if (expected_mod_count != ref_pq->mod_count)
+    throw ConcurrentModificationError("SkipListPriorityQueue::Iterator::operator ++");
+
+  if (current == nullptr)
+    return *this;
+
+  if (can_erase) {
+    prev = current;
+    current = current->next[0];
+  }else
+    can_erase = true;
+
+  return *this;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+auto SkipListPriorityQueue<T,tgt>::Iterator::operator ++ (int) -> SkipListPriorityQueue<T,tgt>::Iterator {
+  if (expected_mod_count != ref_pq->mod_count)
+    throw ConcurrentModificationError("SkipListPriorityQueue::Iterator::operator ++(int)");
+
+  if (current == nullptr)
+    return *this;
+
+  Iterator to_return(*this);
+
+  if (can_erase) {
+    prev = current;
+    current = current->next[0];
+  }else
+    can_erase = true;
+
+  return to_return;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+bool SkipListPriorityQueue<T,tgt>::Iterator::operator == (const SkipListPriorityQueue<T,tgt>::Iterator& rhs) const {
+  const Iterator* rhsASI = dynamic_cast<const Iterator*>(&rhs);
+  if (rhsASI == 0)
+    throw IteratorTypeError("SkipListPriorityQueue::Iterator::operator ==");
+  if (expected_mod_count != ref_pq->mod_count)
+    throw ConcurrentModificationError("SkipListPriorityQueue::Iterator::operator ==");
+  if (ref_pq != rhsASI->ref_pq)
+    throw ComparingDifferentIteratorsError("SkipListPriorityQueue::Iterator::operator ==");
+
+  return current == rhsASI->current;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+bool SkipListPriorityQueue<T,tgt>::Iterator::operator != (const SkipListPriorityQueue<T,tgt>::Iterator& rhs) const {
+  const Iterator* rhsASI = dynamic_cast<const Iterator*>(&rhs);
+  if (rhsASI == 0)
+    throw IteratorTypeError("SkipListPriorityQueue::Iterator::operator !=");
+  if (expected_mod_count != ref_pq->mod_count)
+    throw ConcurrentModificationError("SkipListPriorityQueue::Iterator::operator !=");
+  if (ref_pq != rhsASI->ref_pq)
+    throw ComparingDifferentIteratorsError("SkipListPriorityQueue::Iterator::operator !=");
+
+  return current != rhsASI->current;
+}
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+T& SkipListPriorityQueue<T,tgt>::Iterator::operator *() const {
+  if (expected_mod_count != ref_pq->mod_count)
+    throw ConcurrentModificationError("SkipListPriorityQueue::Iterator::operator *");
+  if (!can_erase || current == nullptr) {
+    std::ostringstream where;
+    where << current
+          << " when front = " << ref_pq->front;
+    throw IteratorPositionIllegal("SkipListPriorityQueue::Iterator::operator * Iterator illegal: "+where.str());
+  }
+
+  return current->value;
+}
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+T* SkipListPriorityQueue<T,tgt>::Iterator::operator ->() const {
+  if (expected_mod_count != ref_pq->mod_count)
+    throw ConcurrentModificationError("SkipListPriorityQueue::Iterator::operator ->");
+  if (!can_erase || current == nullptr) {
+    std::ostringstream where;
+    where << current
+          << " when front = " << ref_pq->front;
+    throw IteratorPositionIllegal("SkipListPriorityQueue::Iterator::operator -> Iterator illegal: "+where.str());
+  }
+
+  return &(current->value);
+}
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//FastIterator class definitions
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+SkipListPriorityQueue<T,tgt>::FastIterator::FastIterator(SN* initial)
+: current(initial) {
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+auto SkipListPriorityQueue<T,tgt>::FastIterator::operator ++ () -> SkipListPriorityQueue<T,tgt>::FastIterator& {
+  current = current->next[0];
+  return *this;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+bool SkipListPriorityQueue<T,tgt>::FastIterator::operator == (const SkipListPriorityQueue<T,tgt>::FastIterator& rhs) const {
+  return current == rhs.current;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+bool SkipListPriorityQueue<T,tgt>::FastIterator::operator != (const SkipListPriorityQueue<T,tgt>::FastIterator& rhs) const {
+  return current != rhs.current;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+T& SkipListPriorityQueue<T,tgt>::FastIterator::operator *() const {
+  return current->value;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+T* SkipListPriorityQueue<T,tgt>::FastIterator::operator ->() const {
+  return &(current->value);
+}
+
+
+}
+
+#endif /* SKIP_LIST_PRIORITY_QUEUE_HPP_ */
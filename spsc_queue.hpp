@@ -0,0 +1,284 @@
+#ifndef SPSC_QUEUE_HPP_
+#define SPSC_QUEUE_HPP_
+
+#include <string>
+#include <iostream>
+#include <sstream>
+#include <atomic>
+#include <new>                  //For placement new (see enqueue)
+#include <utility>              //For std::move
+#include "ics_exceptions.hpp"
+
+
+namespace ics {
+
+
+//A bounded, wait-free queue between exactly one producer thread (which alone calls enqueue and
+//  enqueue_n) and one consumer thread (which alone calls dequeue, try_dequeue, and dequeue_n): no
+//  locks, and each call finishes in a bounded number of steps (enqueue returns 0 when full).
+//Values are in a power-of-two circular array; head/tail count all dequeues/enqueues (wrapping),
+//  so head == tail means empty and tail-head == capacity means full. The consumer writes only head
+//  and the producer only tail, each on its own cache line; each also keeps a cached copy of the
+//  other's index, rereading it (a cache miss) only when the cached copy says empty/full.
+//enqueue_n/dequeue_n move a batch with one index update: one handoff per batch, not per value.
+//size/empty are exact only when called by the producer or consumer (else approximate); str and
+//  operator << must be called only when neither thread is running.
+template<class T> class SPSCQueue {
+  public:
+    //Destructor/Constructors
+    ~SPSCQueue();
+
+    explicit SPSCQueue (int capacity);  //rounded up to a power of two
+    SPSCQueue          (const SPSCQueue<T>& to_copy) = delete;
+
+
+    //Queries
+    bool empty      () const;
+    int  size       () const;
+    int  capacity   () const;
+    std::string str () const; //supplies useful debugging information; contrast to operator <<
+
+
+    //Commands (producer)
+    int  enqueue     (const T& element);         //returns 0 (and does nothing) if full
+    int  enqueue     (T&& element);
+    int  enqueue_n   (const T* values, int n);   //enqueue values[0..answer): as many as fit (up to n)
+
+    //Commands (consumer)
+    T    dequeue     ();                         //throws EmptyError if empty
+    bool try_dequeue (T& answer);                //false (and answer unchanged) if empty
+    int  dequeue_n   (T* answer, int n);         //move up to n values into answer[0..answer)
+
+
+    //Operators
+    SPSCQueue<T>& operator = (const SPSCQueue<T>& rhs) = delete;
+
+    template<class T2>
+    friend std::ostream& operator << (std::ostream& outs, const SPSCQueue<T2>& q);
+
+
+  private:
+    static const int cache_line = 64;
+
+    //Consumer's cache line
+    alignas(cache_line) std::atomic<unsigned> head;  //# values ever dequeued (wrapping)
+    unsigned                      cached_tail = 0;   //A past value of tail: tail >= cached_tail
+    //Producer's cache line
+    alignas(cache_line) std::atomic<unsigned> tail;  //# values ever enqueued (wrapping)
+    unsigned                      cached_head = 0;   //A past value of head: head >= cached_head
+    //Read-only after construction (shared by both threads)
+    alignas(cache_line) T*        q;                 //Raw storage: only q[head..tail) (masked) are constructed
+    unsigned                      mask;              //capacity-1
+
+    //Helper methods
+    unsigned room      (unsigned t, unsigned want);  //Producer: # free slots (>= want if possible)
+    unsigned available (unsigned h, unsigned want);  //Consumer: # values     (>= want if possible)
+};
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//SPSCQueue class and related definitions
+
+//Destructor/Constructors
+
+template<class T>
+SPSCQueue<T>::~SPSCQueue() {
+  for (unsigned i = head.load(); i != tail.load(); ++i)
+    q[i & mask].~T();
+  ::operator delete(q);
+}
+
+
+template<class T>
+SPSCQueue<T>::SPSCQueue(int capacity)
+: head(0), tail(0) {
+  unsigned length = 1;
+  while ((int)length < capacity && length < (1u << 30))
+    length <<= 1;
+  mask = length-1;
+  q = static_cast<T*>(::operator new(length*sizeof(T)));
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Queries
+
+template<class T>
+bool SPSCQueue<T>::empty() const {
+  return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+}
+
+
+template<class T>
+int SPSCQueue<T>::size() const {
+  unsigned h = head.load(std::memory_order_acquire);
+  unsigned t = tail.load(std::memory_order_acquire);
+  int answer = int(t - h);
+  return answer < 0 ? 0 : answer > int(mask+1) ? int(mask+1) : answer;
+}
+
+
+template<class T>
+int SPSCQueue<T>::capacity() const {
+  return int(mask+1);
+}
+
+
+template<class T>
+std::string SPSCQueue<T>::str() const {
+  std::ostringstream answer;
+  answer << "SPSCQueue[";
+
+  for (unsigned i = head.load(); i != tail.load(); ++i)
+    answer << (i == head.load() ? "" : ",") << (i & mask) << ":" << q[i & mask];
+
+  answer << "](capacity=" << mask+1 << ",head=" << head.load() << ",tail=" << tail.load()
+         << ",cached_head=" << cached_head << ",cached_tail=" << cached_tail << ")";
+  return answer.str();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Commands (producer)
+
+template<class T>
+int SPSCQueue<T>::enqueue(const T& element) {
+  unsigned t = tail.load(std::memory_order_relaxed);
+  if (room(t,1) == 0)
+    return 0;
+
+  new (q + (t & mask)) T(element);
+  tail.store(t+1, std::memory_order_release);
+  return 1;
+}
+
+
+template<class T>
+int SPSCQueue<T>::enqueue(T&& element) {
+  unsigned t = tail.load(std::memory_order_relaxed);
+  if (room(t,1) == 0)
+    return 0;
+
+  new (q + (t & mask)) T(std::move(element));
+  tail.store(t+1, std::memory_order_release);
+  return 1;
+}
+
+
+template<class T>
+int SPSCQueue<T>::enqueue_n(const T* values, int n) {
+  unsigned t = tail.load(std::memory_order_relaxed);
+  unsigned count = room(t, n < 0 ? 0 : unsigned(n));
+  if (count > unsigned(n))
+    count = unsigned(n);
+
+  for (unsigned i=0; i<count; ++i)
+    new (q + ((t+i) & mask)) T(values[i]);
+  tail.store(t+count, std::memory_order_release);
+  return int(count);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Commands (consumer)
+
+template<class T>
+T SPSCQueue<T>::dequeue() {
+  unsigned h = head.load(std::memory_order_relaxed);
+  if (available(h,1) == 0)
+    throw EmptyError("SPSCQueue::dequeue");
+
+  T& slot = q[h & mask];
+  T answer = std::move(slot);
+  slot.~T();
+  head.store(h+1, std::memory_order_release);
+  return answer;
+}
+
+
+template<class T>
+bool SPSCQueue<T>::try_dequeue(T& answer) {
+  unsigned h = head.load(std::memory_order_relaxed);
+  if (available(h,1) == 0)
+    return false;
+
+  T& slot = q[h & mask];
+  answer = std::move(slot);
+  slot.~T();
+  head.store(h+1, std::memory_order_release);
+  return true;
+}
+
+
+template<class T>
+int SPSCQueue<T>::dequeue_n(T* answer, int n) {
+  unsigned h = head.load(std::memory_order_relaxed);
+  unsigned count = available(h, n < 0 ? 0 : unsigned(n));
+  if (count > unsigned(n))
+    count = unsigned(n);
+
+  for (unsigned i=0; i<count; ++i) {
+    T& slot = q[(h+i) & mask];
+    answer[i] = std::move(slot);
+    slot.~T();
+  }
+  head.store(h+count, std::memory_order_release);
+  return int(count);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Operators
+
+template<class T>
+std::ostream& operator << (std::ostream& outs, const SPSCQueue<T>& q) {
+  outs << "queue[";
+
+  unsigned h = q.head.load(), t = q.tail.load();
+  for (unsigned i = h; i != t; ++i)
+    outs << (i == h ? "" : ",") << q.q[i & q.mask];
+
+  outs << "]:rear";
+  return outs;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Private helper methods
+
+//The acquire load of head (by the producer) orders the consumer's moves out of the freed slots
+//  before the producer's constructs into them
+template<class T>
+unsigned SPSCQueue<T>::room(unsigned t, unsigned want) {
+  unsigned answer = mask+1 - (t - cached_head);
+  if (answer < want) {
+    cached_head = head.load(std::memory_order_acquire);
+    answer = mask+1 - (t - cached_head);
+  }
+  return answer;
+}
+
+
+//The acquire load of tail (by the consumer) makes the producer's constructed values visible
+template<class T>
+unsigned SPSCQueue<T>::available(unsigned h, unsigned want) {
+  unsigned answer = cached_tail - h;
+  if (answer < want) {
+    cached_tail = tail.load(std::memory_order_acquire);
+    answer = cached_tail - h;
+  }
+  return answer;
+}
+
+}
+
+#endif /* SPSC_QUEUE_HPP_ */
@@ -0,0 +1,78 @@
+//Regression tests for TimerWheel::advance: timers re-armed or cancelled from fire
+//Build: g++ -std=c++11 test_timer_wheel.cpp && ./a.out
+
+#include <cassert>
+#include <iostream>
+#include <vector>
+#include "timer_wheel.hpp"
+
+
+//A timer re-armed from fire for a whole turn of the wheel (2^slot_bits ticks) maps back to the
+//  slot being drained; it must wait the full turn, not fire in the same batch
+void test_rearm_one_turn() {
+  ics::TimerWheel<int> w(0);                 //slot_bits = 8: a turn is 256 ticks
+  std::vector<long long> fired_at;
+  w.schedule(5,1);
+
+  auto fire = [&] (const int& v) {
+    fired_at.push_back(w.now());
+    if (fired_at.size() < 3)
+      w.schedule(w.now()+256,v);
+  };
+
+  assert(w.advance(100,fire) == 1);
+  assert(fired_at.size() == 1 && fired_at[0] == 5);
+  assert(w.size() == 1);
+  assert(w.advance(1000,fire) == 2);
+  assert(fired_at.size() == 3 && fired_at[1] == 261 && fired_at[2] == 517);
+  assert(w.empty());
+}
+
+
+//Re-arming every multiple of a turn (and the next tick) from fire, at every level boundary
+void test_rearm_each_distance() {
+  ics::TimerWheel<int> w(0,2,3);             //4 slots per wheel, horizon 64 ticks
+  for (long long d : {1LL,3LL,4LL,5LL,16LL,17LL,63LL,64LL,65LL,200LL}) {
+    long long start = w.now();
+    long long expected = start+1;
+    int fires = 0;
+    w.schedule(expected,0);
+    w.advance(start+5*d+10, [&] (const int&) {
+      assert(w.now() == expected);
+      if (++fires < 5) {
+        expected = w.now()+d;
+        w.schedule(expected,0);
+      }
+    });
+    assert(fires == 5 && w.empty());
+  }
+}
+
+
+//fire may cancel a timer in the batch being fired: it must not fire, and the slot must stay intact
+void test_cancel_in_batch() {
+  ics::TimerWheel<int> w(0);
+  w.schedule(10,1);                          //Slots list the latest first: 3, 2, 1
+  ics::TimerWheel<int>::Handle next = w.schedule(10,2);
+  w.schedule(10,3);
+  std::vector<int> fired;
+  w.advance(10, [&] (const int& v) {
+    fired.push_back(v);
+    if (v == 3) {
+      assert(w.cancel(next));                //Now first in the detached batch
+      w.schedule(w.now()+256,4);             //Same slot, a turn later
+    }
+  });
+  assert(fired.size() == 2 && w.size() == 1);
+  w.advance(300, [&] (const int& v) {fired.push_back(v); assert(w.now() == 266);});
+  assert(fired.size() == 3 && fired[2] == 4 && w.empty());
+}
+
+
+int main() {
+  test_rearm_one_turn();
+  test_rearm_each_distance();
+  test_cancel_in_batch();
+  std::cout << "test_timer_wheel: ok" << std::endl;
+  return 0;
+}
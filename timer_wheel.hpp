@@ -0,0 +1,480 @@
+#ifndef TIMER_WHEEL_HPP_
+#define TIMER_WHEEL_HPP_
+
+#include <string>
+#include <iostream>
+#include <sstream>
+#include "ics_exceptions.hpp"
+#include "heap_priority_queue.hpp"   //Holds timers beyond the wheels' horizon
+
+
+namespace ics {
+
+
+//A hierarchical timing wheel: levels wheels of 2^slot_bits slots each; a slot at level k covers
+//  2^(slot_bits*k) ticks. schedule and cancel are O(1) (unlink from a doubly-linked slot list).
+//advance fires every timer whose deadline has passed, tick by tick, draining each expired slot as
+//  one batch; when a wheel wraps, the next level's slot is cascaded down into the finer wheels.
+//Timers further out than the top wheel's horizon (2^(slot_bits*levels) ticks) are kept in a
+//  HeapPriorityQueue ordered by deadline and moved into the wheels as they come into range;
+//  cancelling one just frees its node, and the stale heap entry is discarded when it is reached.
+//
+//A Handle names a scheduled timer until it fires or is cancelled; nodes are reused, but each
+//  carries a generation count, so a stale Handle is recognized (contains is false, cancel is a no-op).
+template<class T> class TimerWheel {
+  public:
+    class Handle {
+      public:
+        Handle() {}                       //Names no timer
+        bool operator == (const Handle& rhs) const {return node == rhs.node && generation == rhs.generation;}
+        bool operator != (const Handle& rhs) const {return !(*this == rhs);}
+      private:
+        Handle(int node, int generation) : node(node), generation(generation) {}
+        int node       = -1;
+        int generation = 0;
+        friend class TimerWheel<T>;
+    };
+
+    //Destructor/Constructors
+    ~TimerWheel();
+
+    explicit TimerWheel(long long now = 0, int slot_bits = 8, int levels = 4);
+    TimerWheel(const TimerWheel<T>& to_copy);
+
+
+    //Queries
+    bool empty      () const;
+    int  size       () const;
+    long long now   () const;                   //Last tick advanced to
+    bool contains   (Handle h) const;           //true iff h's timer has neither fired nor been cancelled
+    long long deadline (Handle h) const;        //throws KeyError if !contains(h)
+    std::string str () const; //supplies useful debugging information
+
+
+    //Commands
+    Handle schedule (long long deadline, const T& value);  //deadline <= now() fires on the next tick
+    bool   cancel   (Handle h);                              //false if h's timer already fired/was cancelled
+
+    //Advance to tick to, calling fire(value) for each expiring timer (in tick order); returns # fired
+    //fire may schedule (deadlines <= the tick being fired go to the next tick) and cancel timers
+    template <class F>
+    int  advance (long long to, F fire);
+    void clear   ();
+
+
+    //Operators
+    TimerWheel<T>& operator = (const TimerWheel<T>& rhs);
+
+    template<class T2>
+    friend std::ostream& operator << (std::ostream& outs, const TimerWheel<T2>& tw);
+
+
+  private:
+    static const int free_slot   = -2; //TN.slot values that are not indexes into heads
+    static const int far_slot    = -1;
+    static const int firing_slot = -3; //In the batch advance is firing (listed from firing)
+
+    class TN {
+      public:
+        T         value;
+        long long deadline   = 0;
+        int       next       = -1;     //Next in slot (or free) list
+        int       prev       = -1;     //Previous in slot list; -1 if first
+        int       slot       = free_slot;
+        int       generation = 0;
+    };
+
+    class FarTimer {
+      public:
+        long long deadline;
+        int       node;
+        int       generation;
+        static bool earlier (const FarTimer& a, const FarTimer& b) {return a.deadline < b.deadline;}
+    };
+
+    int        slot_bits;
+    int        levels;
+    long long  mask;                   //Slots per wheel - 1
+    long long  horizon;                //Deadlines >= current+horizon go to far
+    long long  current;                //Next tick to fire: all pending deadlines are >= current
+    int*       heads;                  //heads[level<<slot_bits | slot]: first node in the slot, or -1
+    TN*        nodes;
+    int        length    = 0;          //Physical length of nodes
+    int        used      = 0;          //# of timers scheduled (not fired/cancelled)
+    int        far_used  = 0;          //# of those in far (far may also hold stale entries)
+    int        free_head = -1;         //Free list of nodes, linked through next
+    int        firing    = -1;         //First node of the batch detached from its slot by advance, or -1
+    HeapPriorityQueue<FarTimer,FarTimer::earlier> far;
+
+
+    //Helper methods
+    void allocate   (int heads_length, int new_length);
+    void copy_from  (const TimerWheel<T>& from);
+    int  new_node   ();
+    void free_node  (int n);
+    void place      (int n);           //Link node n into the slot (or far heap) its deadline maps to
+    void unlink     (int n);
+    int& head_of    (int slot);        //heads[slot], or firing for firing_slot
+    void cascade    (int level);       //Re-place every timer in level's slot for current
+    void pull_far   ();                //Move far timers that came into range into the wheels
+};
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//TimerWheel class and related definitions
+
+//Destructor/Constructors
+
+template<class T>
+TimerWheel<T>::~TimerWheel() {
+  delete[] heads;
+  delete[] nodes;
+}
+
+
+template<class T>
+TimerWheel<T>::TimerWheel(long long now, int slot_bits, int levels)
+: slot_bits(slot_bits < 1 ? 1 : slot_bits > 31 ? 31 : slot_bits), levels(levels < 1 ? 1 : levels) {
+  if (this->slot_bits * this->levels > 62)   //Keep horizon representable
+    this->levels = 62 / this->slot_bits;
+
+  mask    = (1LL << this->slot_bits) - 1;
+  horizon = 1LL << (this->slot_bits * this->levels);
+  current = now+1;
+  allocate(this->levels << this->slot_bits, 0);
+}
+
+
+template<class T>
+TimerWheel<T>::TimerWheel(const TimerWheel<T>& to_copy)
+: slot_bits(to_copy.slot_bits), levels(to_copy.levels), mask(to_copy.mask), horizon(to_copy.horizon),
+  current(to_copy.current), far(to_copy.far) {
+  allocate(levels << slot_bits, to_copy.length);
+  copy_from(to_copy);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Queries
+
+template<class T>
+bool TimerWheel<T>::empty() const {
+  return used == 0;
+}
+
+
+template<class T>
+int TimerWheel<T>::size() const {
+  return used;
+}
+
+
+template<class T>
+long long TimerWheel<T>::now() const {
+  return current-1;
+}
+
+
+template<class T>
+bool TimerWheel<T>::contains(Handle h) const {
+  return h.node >= 0 && h.node < length && nodes[h.node].generation == h.generation && nodes[h.node].slot != free_slot;
+}
+
+
+template<class T>
+long long TimerWheel<T>::deadline(Handle h) const {
+  if (!contains(h))
+    throw KeyError("TimerWheel::deadline: Handle names no scheduled timer");
+
+  return nodes[h.node].deadline;
+}
+
+
+template<class T>
+std::string TimerWheel<T>::str() const {
+  std::ostringstream answer;
+  answer << "TimerWheel[";
+
+  bool first = true;
+  for (int s=0; s < (levels << slot_bits); ++s)
+    if (heads[s] != -1) {
+      answer << (first ? "" : ",") << (s >> slot_bits) << "/" << (s & mask) << ":";
+      first = false;
+      for (int n = heads[s]; n != -1; n = nodes[n].next)
+        answer << (n == heads[s] ? "" : "->") << nodes[n].value << "@" << nodes[n].deadline;
+    }
+
+  answer << "](now=" << now() << ",used=" << used << ",far_used=" << far_used << ",length=" << length << ",far=" << far.size() << ")";
+  return answer.str();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Commands
+
+template<class T>
+auto TimerWheel<T>::schedule(long long deadline, const T& value) -> Handle {
+  int n = new_node();
+  nodes[n].value    = value;
+  nodes[n].deadline = deadline < current ? current : deadline;
+  place(n);
+  ++used;
+  return Handle(n,nodes[n].generation);
+}
+
+
+template<class T>
+bool TimerWheel<T>::cancel(Handle h) {
+  if (!contains(h))
+    return false;
+
+  if (nodes[h.node].slot == far_slot)   //Its heap entry goes stale when free_node changes its generation
+    --far_used;
+  else
+    unlink(h.node);
+  free_node(h.node);
+  --used;
+  return true;
+}
+
+
+template<class T>
+template <class F>
+int TimerWheel<T>::advance(long long to, F fire) {
+  int fired = 0;
+  while (current <= to) {
+    //If the wheels are empty no tick can fire or cascade anything: jump to the next far timer's range
+    if (used == far_used) {
+      if (far_used == 0) {
+        current = to+1;
+        break;
+      }
+      long long in_range = far.peek().deadline - horizon + 1;
+      if (in_range > current)
+        current = in_range > to+1 ? to+1 : in_range;
+      if (current > to)
+        break;
+    }
+
+    long long tick = current;
+    pull_far();
+    for (int level=1; level<levels && ((tick >> (slot_bits*(level-1))) & mask) == 0; ++level)
+      cascade(level);
+
+    //Detach the slot's batch before firing it: fire may reschedule into this slot (a deadline
+    //  2^slot_bits ticks away maps back to it), and those timers must wait a full turn.
+    //Timers scheduled by fire for ticks <= this one go to the next tick's slot
+    current = tick+1;
+    firing = heads[tick & mask];
+    heads[tick & mask] = -1;
+    for (int n = firing; n != -1; n = nodes[n].next)
+      nodes[n].slot = firing_slot;
+    while (firing != -1) {
+      int n = firing;
+      unlink(n);
+      T value = nodes[n].value;
+      free_node(n);
+      --used;
+      ++fired;
+      fire(value);
+    }
+  }
+
+  return fired;
+}
+
+
+template<class T>
+void TimerWheel<T>::clear() {
+  for (int s=0; s < (levels << slot_bits); ++s)
+    heads[s] = -1;
+  for (int n=0; n<length; ++n)
+    if (nodes[n].slot != free_slot)
+      free_node(n);
+  far.clear();
+  firing   = -1;
+  used     = 0;
+  far_used = 0;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Operators
+
+template<class T>
+TimerWheel<T>& TimerWheel<T>::operator = (const TimerWheel<T>& rhs) {
+  if (this == &rhs)
+    return *this;
+
+  delete[] heads;
+  delete[] nodes;
+  slot_bits = rhs.slot_bits;
+  levels    = rhs.levels;
+  mask      = rhs.mask;
+  horizon   = rhs.horizon;
+  current   = rhs.current;
+  far       = rhs.far;
+  allocate(levels << slot_bits, rhs.length);
+  copy_from(rhs);
+  return *this;
+}
+
+
+//Timers in deadline order (ties in no particular order)
+template<class T>
+std::ostream& operator << (std::ostream& outs, const TimerWheel<T>& tw) {
+  outs << "timer_wheel[";
+
+  typedef typename TimerWheel<T>::FarTimer FarTimer;
+  HeapPriorityQueue<FarTimer,FarTimer::earlier> by_deadline(tw.used);
+  for (int n=0; n<tw.length; ++n)
+    if (tw.nodes[n].slot != TimerWheel<T>::free_slot)
+      by_deadline.enqueue(FarTimer{tw.nodes[n].deadline,n,tw.nodes[n].generation});
+  for (bool first = true; !by_deadline.empty(); first = false)
+    outs << (first ? "" : ",") << tw.nodes[by_deadline.dequeue().node].value;
+
+  outs << "]:now=" << tw.now();
+  return outs;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Private helper methods
+
+template<class T>
+void TimerWheel<T>::allocate(int heads_length, int new_length) {
+  heads = new int[heads_length];
+  for (int s=0; s<heads_length; ++s)
+    heads[s] = -1;
+  nodes     = new TN[new_length];
+  length    = new_length;
+  used      = 0;
+  far_used  = 0;
+  free_head = -1;
+  firing    = -1;
+}
+
+
+template<class T>
+void TimerWheel<T>::copy_from(const TimerWheel<T>& from) {
+  for (int s=0; s < (levels << slot_bits); ++s)
+    heads[s] = from.heads[s];
+  for (int n=0; n<from.length; ++n)
+    nodes[n] = from.nodes[n];
+  used      = from.used;
+  far_used  = from.far_used;
+  free_head = from.free_head;
+  firing    = from.firing;
+}
+
+
+template<class T>
+int TimerWheel<T>::new_node() {
+  if (free_head == -1) {
+    //Double nodes, threading the new ones onto the free list
+    int new_length = length == 0 ? 16 : 2*length;
+    TN* new_nodes = new TN[new_length];
+    for (int n=0; n<length; ++n)
+      new_nodes[n] = nodes[n];
+    for (int n=new_length-1; n>=length; --n) {
+      new_nodes[n].next = free_head;
+      free_head = n;
+    }
+    delete[] nodes;
+    nodes  = new_nodes;
+    length = new_length;
+  }
+
+  int n = free_head;
+  free_head = nodes[n].next;
+  return n;
+}
+
+
+template<class T>
+void TimerWheel<T>::free_node(int n) {
+  ++nodes[n].generation;
+  nodes[n].slot = free_slot;
+  nodes[n].prev = -1;
+  nodes[n].next = free_head;
+  free_head = n;
+}
+
+
+template<class T>
+void TimerWheel<T>::place(int n) {
+  long long delta = nodes[n].deadline - current;
+  if (delta >= horizon) {
+    nodes[n].slot = far_slot;
+    ++far_used;
+    far.enqueue(FarTimer{nodes[n].deadline,n,nodes[n].generation});
+    return;
+  }
+
+  //Lowest level whose span reaches the deadline; slot chosen by the deadline's bits at that level
+  int level = 0;
+  while (delta >> (slot_bits*(level+1)) != 0)
+    ++level;
+  int s = (level << slot_bits) | int((nodes[n].deadline >> (slot_bits*level)) & mask);
+
+  nodes[n].slot = s;
+  nodes[n].prev = -1;
+  nodes[n].next = heads[s];
+  if (heads[s] != -1)
+    nodes[heads[s]].prev = n;
+  heads[s] = n;
+}
+
+
+template<class T>
+void TimerWheel<T>::unlink(int n) {
+  if (nodes[n].prev == -1)
+    head_of(nodes[n].slot) = nodes[n].next;
+  else
+    nodes[nodes[n].prev].next = nodes[n].next;
+  if (nodes[n].next != -1)
+    nodes[nodes[n].next].prev = nodes[n].prev;
+}
+
+
+template<class T>
+int& TimerWheel<T>::head_of(int slot) {
+  return slot == firing_slot ? firing : heads[slot];
+}
+
+
+template<class T>
+void TimerWheel<T>::cascade(int level) {
+  int s = (level << slot_bits) | int((current >> (slot_bits*level)) & mask);
+  int n = heads[s];
+  heads[s] = -1;
+  while (n != -1) {
+    int next = nodes[n].next;
+    place(n);
+    n = next;
+  }
+}
+
+
+template<class T>
+void TimerWheel<T>::pull_far() {
+  while (!far.empty() && far.peek().deadline - current < horizon) {
+    FarTimer f = far.dequeue();
+    if (nodes[f.node].generation == f.generation && nodes[f.node].slot == far_slot) {
+      --far_used;
+      place(f.node);
+    }
+  }
+}
+
+}
+
+#endif /* TIMER_WHEEL_HPP_ */
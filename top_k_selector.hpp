@@ -0,0 +1,225 @@
+#ifndef TOP_K_SELECTOR_HPP_
+#define TOP_K_SELECTOR_HPP_
+
+#include <string>
+#include <iostream>
+#include <sstream>
+#include <utility>              //For std::move
+#include <algorithm>            //For std::reverse
+#include "ics_exceptions.hpp"
+#include "heap_priority_queue.hpp"
+
+
+namespace ics {
+
+
+//Inverts a priority: the value tgt ranks lowest has the highest priority
+template<class T, bool (*tgt)(const T& a, const T& b)>
+bool lower_priority (const T& a, const T& b) {return tgt(b,a);}
+
+
+//Keeps the k values of highest priority (by tgt) seen in a stream, in O(k) space: a
+//  HeapPriorityQueue with the inverted comparator holds them, so its top is the lowest-priority
+//  value kept. A new value is accepted (replacing that top, with one percolate_down) only if it
+//  has higher priority than it; rejecting costs one comparison and never allocates (the heap is
+//  allocated with length k).
+//For several threads: give each its own TopKSelector, then merge them into one.
+//
+//tgt(a,b) is true, iff a has higher priority than b; it must be supplied in the template, because
+//  the inverted comparator is instantiated from it.
+template<class T, bool (*tgt)(const T& a, const T& b)> class TopKSelector {
+  public:
+    //Constructors (the implicit destructor/copy/= suffice)
+    explicit TopKSelector(int k);
+
+
+    //Queries
+    bool empty      () const;
+    bool full       () const;   //size() == capacity(): now only values beating threshold() are accepted
+    int  size       () const;
+    int  capacity   () const;
+    const T& threshold () const;  //lowest-priority value kept; throws EmptyError if empty
+    std::string str () const; //supplies useful debugging information; contrast to operator <<
+
+
+    //Commands
+    bool offer (const T& element);   //true iff element is (now) among the k kept
+    bool offer (T&& element);
+    int  merge (const TopKSelector<T,tgt>& other);  //offer all of other's values; returns # accepted
+    int  drain_sorted_into (T* buffer);  //buffer[0..size()) = kept values, highest first; leaves selector empty
+    void clear ();
+
+    //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
+    template <class Iterable>
+    int offer_all (const Iterable& i);  //returns # accepted
+
+
+    //Operators
+    template<class T2, bool (*gt2)(const T2& a, const T2& b)>
+    friend std::ostream& operator << (std::ostream& outs, const TopKSelector<T2,gt2>& s);
+
+
+  private:
+    int k;
+    HeapPriorityQueue<T,lower_priority<T,tgt>> kept;   //peek() is the lowest-priority value kept
+};
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//TopKSelector class and related definitions
+
+//Destructor/Constructors
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+TopKSelector<T,tgt>::TopKSelector(int k)
+: k(k < 0 ? 0 : k), kept(k < 0 ? 0 : k) {
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Queries
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+bool TopKSelector<T,tgt>::empty() const {
+  return kept.empty();
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+bool TopKSelector<T,tgt>::full() const {
+  return kept.size() == k;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+int TopKSelector<T,tgt>::size() const {
+  return kept.size();
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+int TopKSelector<T,tgt>::capacity() const {
+  return k;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+const T& TopKSelector<T,tgt>::threshold() const {
+  if (empty())
+    throw EmptyError("TopKSelector::threshold");
+
+  return kept.peek();
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+std::string TopKSelector<T,tgt>::str() const {
+  std::ostringstream answer;
+  answer << "TopKSelector[" << kept.str() << "](k=" << k << ")";
+  return answer.str();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Commands
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+bool TopKSelector<T,tgt>::offer(const T& element) {
+  if (kept.size() < k) {
+    kept.enqueue(element);
+    return true;
+  }
+  if (k == 0 || !tgt(element,kept.peek()))
+    return false;
+
+  kept.replace_top(element);
+  return true;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+bool TopKSelector<T,tgt>::offer(T&& element) {
+  if (kept.size() < k) {
+    kept.enqueue(std::move(element));
+    return true;
+  }
+  if (k == 0 || !tgt(element,kept.peek()))
+    return false;
+
+  kept.replace_top(std::move(element));
+  return true;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+int TopKSelector<T,tgt>::merge(const TopKSelector<T,tgt>& other) {
+  if (this == &other)
+    return 0;
+
+  int count = 0;
+  for (const T& v : other.kept)
+    if (offer(v))
+      ++count;
+
+  return count;
+}
+
+
+//kept drains lowest priority (by tgt) first; reverse that in place
+template<class T, bool (*tgt)(const T& a, const T& b)>
+int TopKSelector<T,tgt>::drain_sorted_into(T* buffer) {
+  int n = kept.drain_sorted_into(buffer);
+  std::reverse(buffer,buffer+n);
+  return n;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+void TopKSelector<T,tgt>::clear() {
+  kept.clear();
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+template <class Iterable>
+int TopKSelector<T,tgt>::offer_all (const Iterable& i) {
+  int count = 0;
+  for (const T& v : i)
+    if (offer(v))
+      ++count;
+
+  return count;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Operators
+
+template<class T, bool (*tgt)(const T& a, const T& b)>
+std::ostream& operator << (std::ostream& outs, const TopKSelector<T,tgt>& s) {
+  outs << "top_k[";
+
+  if (!s.empty()) {
+    TopKSelector<T,tgt> temp(s);
+    T* sorted = new T[temp.size()];
+    int n = temp.drain_sorted_into(sorted);
+    outs << sorted[0];
+    for (int i = 1; i < n; ++i)
+      outs << "," << sorted[i];
+    delete[] sorted;
+  }
+
+  outs << "]:highest first";
+  return outs;
+}
+
+}
+
+#endif /* TOP_K_SELECTOR_HPP_ */
@@ -0,0 +1,241 @@
+#ifndef WORK_STEALING_DEQUE_HPP_
+#define WORK_STEALING_DEQUE_HPP_
+
+#include <string>
+#include <iostream>
+#include <sstream>
+#include <atomic>
+#include <type_traits>
+#include "ics_exceptions.hpp"
+
+
+namespace ics {
+
+
+//A Chase-Lev work-stealing deque: its owner thread pushes and pops values (tasks) at the bottom,
+//  like a stack, while any other thread may steal the oldest value from the top. Values are in a
+//  circular array indexed by top <= bottom (which only increase/only the owner changes); the owner
+//  and thieves contend (with a CAS on top) only for the last value. When full, the owner copies
+//  the values to an array twice as long; old arrays (which a thief may still be reading) are kept
+//  until the destructor.
+//T must be trivially copyable (typically a pointer to a task): the array's values are atomic.
+//str and operator << may be called only when no other thread is using the deque.
+template<class T> class WorkStealingDeque {
+  public:
+    //Destructor/Constructors
+    ~WorkStealingDeque();
+
+    explicit WorkStealingDeque (int initial_length = 64);  //rounded up to a power of two
+    WorkStealingDeque          (const WorkStealingDeque<T>& to_copy) = delete;
+
+
+    //Queries
+    bool empty      () const;   //Approximate while other threads are stealing
+    int  size       () const;   //Approximate while other threads are stealing
+    std::string str () const;   //supplies useful debugging information; contrast to operator <<
+
+
+    //Commands (owner)
+    void push (const T& element);
+    bool pop  (T& answer);      //Newest value; false (and answer unchanged) if empty
+
+    //Commands (any thread)
+    bool steal (T& answer);     //Oldest value; false (and answer unchanged) if empty or another thread won it
+
+
+    //Operators
+    WorkStealingDeque<T>& operator = (const WorkStealingDeque<T>& rhs) = delete;
+
+    template<class T2>
+    friend std::ostream& operator << (std::ostream& outs, const WorkStealingDeque<T2>& d);
+
+
+  private:
+    static const int cache_line = 64;
+
+    class Ring {
+      public:
+        Ring (long long length, Ring* previous) : mask(length-1), values(new std::atomic<T>[length]), previous(previous) {}
+        ~Ring() {delete[] values;}
+
+        T    get (long long i) const         {return values[i & mask].load(std::memory_order_relaxed);}
+        void put (long long i, const T& v)   {values[i & mask].store(v, std::memory_order_relaxed);}
+
+        long long        mask;       //length-1
+        std::atomic<T>*  values;
+        Ring*            previous;   //The Ring this one replaced (kept for thieves still reading it)
+    };
+
+    //padding keeps top and bottom on different cache lines (even when allocated by new)
+    std::atomic<long long> top;              //Index of the oldest value (thieves CAS it)
+    char                   padding[cache_line];
+    std::atomic<long long> bottom;           //Index after the newest value (only the owner writes it)
+    std::atomic<Ring*>     ring;
+
+    //Helper methods
+    Ring* grow (Ring* r, long long t, long long b);    //Owner: copy values [t,b) into a Ring twice as long
+};
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//WorkStealingDeque class and related definitions
+
+//Destructor/Constructors
+
+template<class T>
+WorkStealingDeque<T>::~WorkStealingDeque() {
+  for (Ring* r = ring.load(); r != nullptr; /*see body*/) {
+    Ring* to_delete = r;
+    r = r->previous;
+    delete to_delete;
+  }
+}
+
+
+template<class T>
+WorkStealingDeque<T>::WorkStealingDeque(int initial_length)
+: top(0), bottom(0) {
+  static_assert(std::is_trivially_copyable<T>::value, "WorkStealingDeque: T must be trivially copyable");
+  long long length = 1;
+  while (length < initial_length)
+    length <<= 1;
+  ring.store(new Ring(length,nullptr));
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Queries
+
+template<class T>
+bool WorkStealingDeque<T>::empty() const {
+  return size() == 0;
+}
+
+
+template<class T>
+int WorkStealingDeque<T>::size() const {
+  long long answer = bottom.load() - top.load();
+  return answer < 0 ? 0 : int(answer);
+}
+
+
+template<class T>
+std::string WorkStealingDeque<T>::str() const {
+  std::ostringstream answer;
+  answer << "WorkStealingDeque[";
+
+  Ring* r = ring.load();
+  long long t = top.load(), b = bottom.load();
+  for (long long i = t; i < b; ++i)
+    answer << (i == t ? "" : ",") << (i & r->mask) << ":" << r->get(i);
+
+  answer << "](length=" << r->mask+1 << ",top=" << t << ",bottom=" << b << ")";
+  return answer.str();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Commands (owner)
+
+template<class T>
+void WorkStealingDeque<T>::push(const T& element) {
+  long long b = bottom.load(std::memory_order_relaxed);
+  long long t = top.load(std::memory_order_acquire);
+  Ring* r = ring.load(std::memory_order_relaxed);
+  if (b-t > r->mask)
+    r = grow(r,t,b);
+
+  r->put(b,element);
+  bottom.store(b+1, std::memory_order_release);     //Publishes the value to thieves
+}
+
+
+//Claim bottom-1 first (so thieves see it gone), then check top: if a thief may also want the
+//  last value, CAS top to settle who gets it
+template<class T>
+bool WorkStealingDeque<T>::pop(T& answer) {
+  long long b = bottom.load(std::memory_order_relaxed) - 1;
+  Ring* r = ring.load(std::memory_order_relaxed);
+  bottom.store(b);                                  //seq_cst: ordered before the load of top
+  long long t = top.load();
+
+  if (t > b) {                                      //Was empty
+    bottom.store(b+1, std::memory_order_relaxed);
+    return false;
+  }
+
+  T value = r->get(b);
+  if (t < b) {                                      //More than one value: no thief can reach b
+    answer = value;
+    return true;
+  }
+
+  bool won = top.compare_exchange_strong(t,t+1);    //The last value: race the thieves for it
+  bottom.store(b+1, std::memory_order_relaxed);
+  if (won)
+    answer = value;
+  return won;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Commands (any thread)
+
+template<class T>
+bool WorkStealingDeque<T>::steal(T& answer) {
+  long long t = top.load();                         //seq_cst: ordered before the load of bottom
+  long long b = bottom.load();
+  if (t >= b)
+    return false;
+
+  Ring* r = ring.load(std::memory_order_acquire);
+  T value = r->get(t);
+  if (!top.compare_exchange_strong(t,t+1))          //Lost to the owner or another thief
+    return false;
+
+  answer = value;
+  return true;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Operators
+
+template<class T>
+std::ostream& operator << (std::ostream& outs, const WorkStealingDeque<T>& d) {
+  outs << "deque[";
+
+  typename WorkStealingDeque<T>::Ring* r = d.ring.load();
+  long long t = d.top.load(), b = d.bottom.load();
+  for (long long i = t; i < b; ++i)
+    outs << (i == t ? "" : ",") << r->get(i);
+
+  outs << "]:bottom";
+  return outs;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Private helper methods
+
+template<class T>
+auto WorkStealingDeque<T>::grow(Ring* r, long long t, long long b) -> Ring* {
+  Ring* bigger = new Ring(2*(r->mask+1), r);
+  for (long long i = t; i < b; ++i)
+    bigger->put(i, r->get(i));
+  ring.store(bigger, std::memory_order_release);
+  return bigger;
+}
+
+}
+
+#endif /* WORK_STEALING_DEQUE_HPP_ */